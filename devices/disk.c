@@ -7,6 +7,7 @@
 #include "threads/io.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -80,6 +81,11 @@ struct channel {
 #define CHANNEL_CNT 2
 static struct channel channels[CHANNEL_CNT];
 
+/* Identifies disk D and sector SEC_NO in trace events.  Bit 63
+   of the sector marks writes. */
+#define TRACE_DISK(D) ((uint64_t) ((D)->channel - channels) << 1 | (D)->dev_no)
+#define TRACE_SECTOR(SEC_NO, WRITE) ((uint64_t) (SEC_NO) | (uint64_t) (WRITE) << 63)
+
 static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
@@ -217,8 +223,10 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
 	c = d->channel;
 	lock_acquire (&c->lock);
 	select_sector (d, sec_no);
+	trace_event (TRACE_DISK_ISSUE, TRACE_DISK (d), TRACE_SECTOR (sec_no, false));
 	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
 	sema_down (&c->completion_wait);
+	trace_event (TRACE_DISK_COMPLETE, TRACE_DISK (d), TRACE_SECTOR (sec_no, false));
 	if (!wait_while_busy (d))
 		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
 	input_sector (c, buffer);
@@ -241,11 +249,13 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
 	c = d->channel;
 	lock_acquire (&c->lock);
 	select_sector (d, sec_no);
+	trace_event (TRACE_DISK_ISSUE, TRACE_DISK (d), TRACE_SECTOR (sec_no, true));
 	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
 	if (!wait_while_busy (d))
 		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
 	output_sector (c, buffer);
 	sema_down (&c->completion_wait);
+	trace_event (TRACE_DISK_COMPLETE, TRACE_DISK (d), TRACE_SECTOR (sec_no, true));
 	d->write_cnt++;
 	lock_release (&c->lock);
 }
@@ -5,11 +5,12 @@
 
 /* Stores keys from the keyboard and serial port. */
 static struct intq buffer;
+static uint8_t buffer_buf[INTQ_BUFSIZE];
 
 /* Initializes the input buffer. */
 void
 input_init (void) {
-	intq_init (&buffer);
+	intq_init (&buffer, buffer_buf, sizeof buffer_buf);
 }
 
 /* Adds a key to the input buffer.
@@ -24,17 +25,21 @@ input_putc (uint8_t key) {
 }
 
 /* Retrieves a key from the input buffer.
-   If the buffer is empty, waits for a key to be pressed. */
+   If the buffer is empty, waits for a key to be pressed.
+
+   We are the buffer's only consumer, so taking the key needs no
+   interrupts off.  The serial port stops receiving while the
+   buffer is full, so if we may just have taken it out of that
+   state, turn receiving back on. */
 uint8_t
 input_getc (void) {
-	enum intr_level old_level;
-	uint8_t key;
-
-	old_level = intr_disable ();
-	key = intq_getc (&buffer);
-	serial_notify ();
-	intr_set_level (old_level);
+	uint8_t key = intq_getc (&buffer);
 
+	if (intq_count (&buffer) >= sizeof buffer_buf - 1) {
+		enum intr_level old_level = intr_disable ();
+		serial_notify ();
+		intr_set_level (old_level);
+	}
 	return key;
 }
 
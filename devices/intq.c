@@ -2,30 +2,43 @@
 #include <debug.h>
 #include "threads/thread.h"
 
-static int next (int pos);
 static void wait (struct intq *q, struct thread **waiter);
 static void signal (struct intq *q, struct thread **waiter);
 
-/* Initializes interrupt queue Q. */
+/* Initializes interrupt queue Q to hold up to SIZE bytes in BUF.
+   SIZE must be a power of 2. */
 void
-intq_init (struct intq *q) {
+intq_init (struct intq *q, uint8_t *buf, size_t size) {
+	ASSERT (buf != NULL);
+	ASSERT (size > 0 && (size & (size - 1)) == 0);
+
 	lock_init (&q->lock);
 	q->not_full = q->not_empty = NULL;
+	q->buf = buf;
+	q->size = size;
 	q->head = q->tail = 0;
 }
 
-/* Returns true if Q is empty, false otherwise. */
+/* Returns true if Q is empty, false otherwise.  The answer may be
+   stale unless the caller is Q's consumer. */
 bool
 intq_empty (const struct intq *q) {
-	ASSERT (intr_get_level () == INTR_OFF);
 	return q->head == q->tail;
 }
 
-/* Returns true if Q is full, false otherwise. */
+/* Returns true if Q is full, false otherwise.  The answer may be
+   stale unless the caller is Q's producer. */
 bool
 intq_full (const struct intq *q) {
-	ASSERT (intr_get_level () == INTR_OFF);
-	return next (q->head) == q->tail;
+	return q->head - q->tail == q->size;
+}
+
+/* Returns the number of bytes in Q.  Only Q's consumer can take
+   bytes out, so to it the answer is a lower bound, and to Q's
+   producer an upper bound. */
+size_t
+intq_count (const struct intq *q) {
+	return q->head - q->tail;
 }
 
 /* Removes a byte from Q and returns it.
@@ -36,17 +49,8 @@ uint8_t
 intq_getc (struct intq *q) {
 	uint8_t byte;
 
-	ASSERT (intr_get_level () == INTR_OFF);
-	while (intq_empty (q)) {
-		ASSERT (!intr_context ());
-		lock_acquire (&q->lock);
+	while (intq_get_many (q, &byte, 1) == 0)
 		wait (q, &q->not_empty);
-		lock_release (&q->lock);
-	}
-
-	byte = q->buf[q->tail];
-	q->tail = next (q->tail);
-	signal (q, &q->not_full);
 	return byte;
 }
 
@@ -56,36 +60,89 @@ intq_getc (struct intq *q) {
    removed. */
 void
 intq_putc (struct intq *q, uint8_t byte) {
-	ASSERT (intr_get_level () == INTR_OFF);
-	while (intq_full (q)) {
-		ASSERT (!intr_context ());
-		lock_acquire (&q->lock);
+	while (intq_put_many (q, &byte, 1) == 0)
 		wait (q, &q->not_full);
-		lock_release (&q->lock);
-	}
+}
 
-	q->buf[q->head] = byte;
-	q->head = next (q->head);
-	signal (q, &q->not_empty);
+/* Removes up to CNT bytes from Q into BUF, without sleeping.
+   Returns the number of bytes removed. */
+size_t
+intq_get_many (struct intq *q, uint8_t *buf, size_t cnt) {
+	size_t tail = q->tail;
+	size_t avail = q->head - tail;
+	size_t i;
+
+	if (cnt > avail)
+		cnt = avail;
+	if (cnt == 0)
+		return 0;
+
+	/* x86 does not reorder loads with other loads, so the bytes
+	   read below are the ones the producer stored before it
+	   advanced HEAD.  The compiler must not reorder them either. */
+	barrier ();
+	for (i = 0; i < cnt; i++)
+		buf[i] = q->buf[(tail + i) & (q->size - 1)];
+	barrier ();
+	q->tail = tail + cnt;
+
+	signal (q, &q->not_full);
+	return cnt;
 }
 
-/* Returns the position after POS within an intq. */
-static int
-next (int pos) {
-	return (pos + 1) % INTQ_BUFSIZE;
+/* Adds up to CNT bytes from BUF to the end of Q, without
+   sleeping.  Returns the number of bytes added. */
+size_t
+intq_put_many (struct intq *q, const uint8_t *buf, size_t cnt) {
+	size_t head = q->head;
+	size_t room = q->size - (head - q->tail);
+	size_t i;
+
+	if (cnt > room)
+		cnt = room;
+	if (cnt == 0)
+		return 0;
+
+	/* Stores are not reordered with other stores on x86, so the
+	   consumer sees the new bytes before it sees HEAD move. */
+	barrier ();
+	for (i = 0; i < cnt; i++)
+		q->buf[(head + i) & (q->size - 1)] = buf[i];
+	barrier ();
+	q->head = head + cnt;
+
+	signal (q, &q->not_empty);
+	return cnt;
 }
 
 /* WAITER must be the address of Q's not_empty or not_full
-   member.  Waits until the given condition is true. */
+   member.  Waits until the given condition is true, or returns
+   at once if it already is.
+
+   The other side may be on another CPU, where turning interrupts
+   off does not keep it out.  So the waiter is published before
+   the condition is checked, and signal() checks the condition's
+   change before the waiter, each with a full fence in between:
+   then at least one of the two sees the other.  Whoever takes the
+   waiter back out of *WAITER, with an atomic exchange, decides
+   whether the thread sleeps. */
 static void
-wait (struct intq *q UNUSED, struct thread **waiter) {
+wait (struct intq *q, struct thread **waiter) {
+	enum intr_level old_level;
+
 	ASSERT (!intr_context ());
-	ASSERT (intr_get_level () == INTR_OFF);
-	ASSERT ((waiter == &q->not_empty && intq_empty (q))
-			|| (waiter == &q->not_full && intq_full (q)));
+	ASSERT (waiter == &q->not_empty || waiter == &q->not_full);
 
+	lock_acquire (&q->lock);
+	old_level = intr_disable ();
 	*waiter = thread_current ();
-	thread_block ();
+	__atomic_thread_fence (__ATOMIC_SEQ_CST);
+	if (waiter == &q->not_empty ? intq_empty (q) : intq_full (q))
+		thread_block ();
+	else if (__atomic_exchange_n (waiter, NULL, __ATOMIC_SEQ_CST) == NULL)
+		thread_block (); // signal()이 이미 가져갔으므로 곧 깨운다.
+	intr_set_level (old_level);
+	lock_release (&q->lock);
 }
 
 /* WAITER must be the address of Q's not_empty or not_full
@@ -93,13 +150,16 @@ wait (struct intq *q UNUSED, struct thread **waiter) {
    thread is waiting for the condition, wakes it up and resets
    the waiting thread. */
 static void
-signal (struct intq *q UNUSED, struct thread **waiter) {
-	ASSERT (intr_get_level () == INTR_OFF);
-	ASSERT ((waiter == &q->not_empty && !intq_empty (q))
-			|| (waiter == &q->not_full && !intq_full (q)));
-
-	if (*waiter != NULL) {
-		thread_unblock (*waiter);
-		*waiter = NULL;
-	}
+signal (struct intq *q, struct thread **waiter) {
+	struct thread *t;
+
+	ASSERT (waiter == &q->not_empty || waiter == &q->not_full);
+
+	__atomic_thread_fence (__ATOMIC_SEQ_CST); // HEAD나 TAIL을 옮긴 것이 먼저 보이게 한다.
+	if (*(struct thread *volatile *) waiter == NULL) // 대부분은 기다리는 스레드가 없다.
+		return;
+
+	t = __atomic_exchange_n (waiter, NULL, __ATOMIC_SEQ_CST);
+	if (t != NULL)
+		thread_unblock (t);
 }
@@ -5,6 +5,7 @@
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
+#include "threads/spinlock.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
 
@@ -51,8 +52,25 @@
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
+/* Data to be transmitted.  A bigger queue lets a thread hand a
+   whole line or write() buffer to the port at once, instead of
+   sleeping every 64 bytes until the UART catches up.  Must be a
+   power of 2. */
+#define TXQ_SIZE 4096
 static struct intq txq;
+static uint8_t txq_buf[TXQ_SIZE];
+
+/* Most bytes serial_putbuf() copies into TXQ with interrupts off
+   at a time, so that a large buffer does not delay the timer
+   interrupt by a whole queue's worth of copying. */
+#define PUTBUF_CHUNK 256
+
+/* Serializes the port's registers and the taking of bytes out of
+   TXQ, which serial_interrupt() does on the bootstrap processor
+   while threads on any CPU may have to make room by polling.  A
+   writer holding it cannot sleep until TXQ has room, so it sends
+   a byte itself instead. */
+static struct spinlock port_lock;
 
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
@@ -70,7 +88,8 @@ init_poll (void) {
 	outb (FCR_REG, 0);                    /* Disable FIFO. */
 	set_serial (115200);                  /* 115.2 kbps, N-8-1. */
 	outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-	intq_init (&txq);
+	intq_init (&txq, txq_buf, sizeof txq_buf);
+	spinlock_init (&port_lock);
 	mode = POLL;
 }
 
@@ -87,48 +106,76 @@ serial_init_queue (void) {
 
 	intr_register_ext (0x20 + 4, serial_interrupt, "serial");
 	mode = QUEUE;
-	old_level = intr_disable ();
+	old_level = spinlock_acquire (&port_lock);
 	write_ier ();
-	intr_set_level (old_level);
+	spinlock_release (&port_lock, old_level);
 }
 
 /* Sends BYTE to the serial port. */
 void
 serial_putc (uint8_t byte) {
-	enum intr_level old_level = intr_disable ();
+	enum intr_level old_level;
+
+	/* If we're not set up for interrupt-driven I/O yet,
+	   use dumb polling to transmit a byte. */
+	if (mode == UNINIT)
+		init_poll ();
 
-	if (mode != QUEUE) {
-		/* If we're not set up for interrupt-driven I/O yet,
-		   use dumb polling to transmit a byte. */
-		if (mode == UNINIT)
-			init_poll ();
+	old_level = spinlock_acquire (&port_lock);
+	if (mode != QUEUE)
 		putc_poll (byte);
-	} else {
+	else {
 		/* Otherwise, queue a byte and update the interrupt enable
 		   register. */
-		if (old_level == INTR_OFF && intq_full (&txq)) {
-			/* Interrupts are off and the transmit queue is full.
-			   If we wanted to wait for the queue to empty,
-			   we'd have to reenable interrupts.
-			   That's impolite, so we'll send a character via
-			   polling instead. */
+		if (intq_full (&txq)) {
+			/* The transmit queue is full.  We can't sleep until
+			   it has room while holding the port lock, so we'll
+			   send a character via polling instead. */
 			putc_poll (intq_getc (&txq));
 		}
 
 		intq_putc (&txq, byte);
 		write_ier ();
 	}
+	spinlock_release (&port_lock, old_level);
+}
 
-	intr_set_level (old_level);
+/* Sends the N bytes in BUF to the serial port, queuing as many
+   at a time as fit, up to PUTBUF_CHUNK. */
+void
+serial_putbuf (const uint8_t *buf, size_t n) {
+	while (n > 0) {
+		size_t chunk = n < PUTBUF_CHUNK ? n : PUTBUF_CHUNK;
+		enum intr_level old_level = spinlock_acquire (&port_lock);
+		size_t cnt = mode == QUEUE ? intq_put_many (&txq, buf, chunk) : 0;
+
+		if (cnt > 0)
+			write_ier ();
+		spinlock_release (&port_lock, old_level);
+
+		if (cnt == 0) { // 폴링 모드이거나 큐가 가득 찼다.
+			serial_putc (*buf);
+			cnt = 1;
+		}
+		buf += cnt;
+		n -= cnt;
+	}
 }
 
 /* Flushes anything in the serial buffer out the port in polling
-   mode. */
+   mode.  Called by debug_panic(), so this CPU may already hold the
+   port lock. */
 void
 serial_flush (void) {
 	enum intr_level old_level = intr_disable ();
+	bool held = spinlock_held_by_current_cpu (&port_lock);
+
+	if (!held)
+		spinlock_acquire (&port_lock);
 	while (!intq_empty (&txq))
 		putc_poll (intq_getc (&txq));
+	if (!held)
+		spinlock_release (&port_lock, INTR_OFF);
 	intr_set_level (old_level);
 }
 
@@ -139,8 +186,11 @@ serial_flush (void) {
 void
 serial_notify (void) {
 	ASSERT (intr_get_level () == INTR_OFF);
-	if (mode == QUEUE)
+	if (mode == QUEUE) {
+		spinlock_acquire (&port_lock);
 		write_ier ();
+		spinlock_release (&port_lock, INTR_OFF);
+	}
 }
 
 /* Configures the serial port for BPS bits per second. */
@@ -162,12 +212,12 @@ set_serial (int bps) {
 	outb (LCR_REG, LCR_N81);
 }
 
-/* Update interrupt enable register. */
+/* Update interrupt enable register.  The port lock must be held. */
 static void
 write_ier (void) {
 	uint8_t ier = 0;
 
-	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spinlock_held_by_current_cpu (&port_lock));
 
 	/* Enable transmit interrupt if we have any characters to
 	   transmit. */
@@ -207,9 +257,11 @@ serial_interrupt (struct intr_frame *f UNUSED) {
 
 	/* As long as we have a byte to transmit, and the hardware is
 	   ready to accept a byte for transmission, transmit a byte. */
+	spinlock_acquire (&port_lock);
 	while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0)
 		outb (THR_REG, intq_getc (&txq));
 
 	/* Update interrupt enable register based on queue status. */
 	write_ier ();
+	spinlock_release (&port_lock, INTR_OFF);
 }
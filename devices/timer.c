@@ -3,10 +3,17 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/lapic.h"
+#include "threads/profile.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#ifdef USERPROG
+#include "userprog/vdso.h"
+#endif
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -25,28 +32,91 @@ static int64_t ticks; // 프로그램 부트 시간 (현재 시각(eg. 12시))
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Longest time spent in timer_interrupt(), in TSC cycles. */
+static uint64_t max_tick_cycles;
+
+/*------------------------- [P1] High-Resolution Clock --------------------------*/
+/* Ticks to measure the TSC over in timer_calibrate(). */
+#define TSC_CALIBRATE_TICKS 10
+
+/* timer_ns() is TSC_NS_BASE plus the TSC cycles since TSC_BASE
+   converted to nanoseconds.  TSC_NS_MULT is nanoseconds per
+   cycle in 32.32 fixed point, or 0 until timer_calibrate() has
+   measured the TSC. */
+static uint64_t tsc_hz;
+static uint64_t tsc_base;
+static uint64_t tsc_ns_base;
+static uint64_t tsc_ns_mult;
+
+/*------------------------- [P1] Tickless Idle --------------------------*/
+/* If false (default), the timer interrupts TIMER_FREQ times per
+   second no matter what.  If true, an idle CPU arms a one-shot
+   timer for the next tick that has work to do instead.
+   Controlled by kernel command-line option "-tickless". */
+bool timer_tickless;
+
+/* 8254 input frequency, and its counts per timer tick. */
+#define PIT_HZ 1193180
+#define PIT_TICK_COUNT ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* The tick comes from the 8254 until timer_calibrate() has
+   measured the local APIC timer against it, and from the local
+   APIC timer after that.  The 8254 is only a fallback for CPUs
+   without a local APIC: it is shared by all CPUs, and an I/O port
+   access to reprogram it costs a microsecond or more on each
+   idle entry and exit, where the local APIC timer is a register
+   write.  TICK_COUNT is the active timer's counts per tick, and
+   oneshot_max_ticks the longest one-shot its counter can hold,
+   in ticks.
+
+   Application processors take their tick from their own local
+   APIC timers, at the same rate, but only the bootstrap processor
+   counts `ticks', wakes up sleepers, and stops its tick when idle;
+   the others only charge the tick to the thread they are
+   running. */
+static bool use_lapic;
+static uint32_t tick_count = PIT_TICK_COUNT;
+static int64_t oneshot_max_ticks = 0xffff / PIT_TICK_COUNT;
+
+/* Ticks the armed one-shot stands for, or 0 while periodic. */
+static int64_t oneshot_ticks;
+
+/* Ticks already counted by timer_idle_exit() whose thread_tick()
+   is still owed by the next timer interrupt. */
+static int64_t skipped_ticks;
+
+/* Number of timer interrupts taken since boot. */
+static int64_t timer_intr_cnt;
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void calibrate_tsc (void);
+static void calibrate_lapic (void);
+static void publish_ticks (void);
+static void tick_periodic (void);
+static void tick_oneshot (uint32_t count);
+static bool tick_expired (void);
+static uint32_t tick_left (void);
+static void pit_periodic (void);
+static void pit_oneshot (uint16_t count);
+static bool pit_expired (void);
+static uint16_t pit_read (void);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
-   corresponding interrupt. */
+   corresponding interrupt.  timer_calibrate() later hands the
+   tick over to the local APIC timer. */
 void
 timer_init (void) {
-	/* 8254 input frequency divided by TIMER_FREQ, rounded to
-	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
-
-	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	outb (0x40, count & 0xff);
-	outb (0x40, count >> 8);
+	pit_periodic ();
 
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
-/* Calibrates loops_per_tick, used to implement brief delays. */
+/* Calibrates loops_per_tick, used to implement brief delays,
+   and the TSC and local APIC timer against the tick. */
 void
 timer_calibrate (void) {
 	unsigned high_bit, test_bit;
@@ -69,6 +139,22 @@ timer_calibrate (void) {
 			loops_per_tick |= test_bit;
 
 	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+	calibrate_tsc ();
+	calibrate_lapic ();
+}
+
+/* Starts the tick on an application processor, from its local
+   APIC timer, which counts at the same rate as the bootstrap
+   processor's.  Without a calibrated local APIC timer the AP gets
+   no tick, and only switches threads when it blocks or is sent
+   a reschedule IPI. */
+void
+timer_init_ap (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (use_lapic)
+		lapic_timer_periodic (tick_count);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -81,6 +167,24 @@ timer_ticks (void) {
 	return t;
 }
 
+/* Returns the number of nanoseconds since the OS booted.  Reads
+   the TSC, so it has sub-tick resolution once timer_calibrate()
+   has run; before that it only advances once per tick. */
+uint64_t
+timer_ns (void) {
+	if (tsc_ns_mult == 0)
+		return timer_ticks () * (NSEC_PER_SEC / TIMER_FREQ);
+	return tsc_ns_base + (uint64_t)
+		(((unsigned __int128) (rdtsc () - tsc_base) * tsc_ns_mult) >> 32);
+}
+
+/* Returns the TSC frequency in Hz, or 0 if it is not calibrated
+   yet. */
+uint64_t
+timer_tsc_hz (void) {
+	return tsc_hz;
+}
+
 /* Returns the number of timer ticks elapsed since THEN, which
    should be a value once returned by timer_ticks(). */
 int64_t
@@ -126,19 +230,306 @@ timer_nsleep (int64_t ns) {
 /* Prints timer statistics. */
 void
 timer_print_stats (void) {
-	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+	if (timer_tickless)
+		printf ("Timer: %"PRId64" ticks, %"PRId64" interrupts\n",
+				timer_ticks (), timer_intr_cnt);
+	else
+		printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
 }
 
+/* Returns the number of timer interrupts taken since boot.
+   Without "-tickless" this is the same as timer_ticks(). */
+int64_t
+timer_interrupts (void) {
+	enum intr_level old_level = intr_disable ();
+	int64_t cnt = timer_intr_cnt;
+	intr_set_level (old_level);
+	return cnt;
+}
+
+/* Returns the worst-case timer interrupt handler latency, in TSC
+   cycles, seen since boot or the last call to
+   timer_reset_max_tick_cycles(). */
+uint64_t
+timer_max_tick_cycles (void) {
+	return max_tick_cycles;
+}
+
+/* Restarts worst-case timer interrupt latency tracking. */
+void
+timer_reset_max_tick_cycles (void) {
+	enum intr_level old_level = intr_disable ();
+	max_tick_cycles = 0;
+	intr_set_level (old_level);
+}
+
 /*------------------------- [P1] Alarm Clock --------------------------*/
 /* Timer interrupt handler. */
 static void
-timer_interrupt (struct intr_frame *args UNUSED) {
-	ticks++;
-	thread_tick (); // update the cpu usage for running process
+timer_interrupt (struct intr_frame *args) {
+	uint64_t start = rdtsc ();
+	uint64_t cycles;
+	int64_t elapsed = 1;
+	int64_t tick;
+
+	if (this_cpu ()->id != 0) { // AP는 타임 슬라이스만 센다.
+		thread_tick (ticks, (args->cs & 3) == 3);
+		return;
+	}
+
+	timer_intr_cnt++;
+	if (oneshot_ticks != 0) { // 유휴 상태에서 건너뛴 틱들을 한꺼번에 반영한다.
+		elapsed = oneshot_ticks;
+		oneshot_ticks = 0;
+		tick_periodic ();
+	}
+
+	ticks += elapsed;
+	publish_ticks ();
+	profile_sample (args); // 인터럽트된 위치를 샘플링한다 (-profile).
+
+	/* 건너뛴 틱도 하나씩 그 틱의 시각으로 처리해야 MLFQS의 매초, 4틱마다
+	   하는 갱신이 빠지거나 겹치지 않는다. 이 틱들은 유휴 상태였다. */
+	for (tick = ticks - elapsed - skipped_ticks + 1; tick < ticks; tick++)
+		thread_idle_tick (tick);
+	skipped_ticks = 0;
+	thread_tick (ticks, (args->cs & 3) == 3); // update the cpu usage for running process
+	thread_awake (ticks); // 타이밍 휠을 현재 시각까지 돌리면서 깨울 스레드를 깨운다.
+
+	cycles = rdtsc () - start;
+	if (cycles > max_tick_cycles)
+		max_tick_cycles = cycles;
+}
+
+/*------------------------- [P1] Tickless Idle --------------------------*/
+/* Called by the idle thread, with interrupts off, right before it
+   halts.  Stops the periodic tick until the next tick at which a
+   sleeper may wake up, at most oneshot_max_ticks away.  The
+   one-shot expires exactly on the tick boundary the periodic
+   timer would have hit, so the tick phase is not lost. */
+void
+timer_idle_enter (void) {
+	int64_t next, delta;
+	uint32_t left;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!timer_tickless || oneshot_ticks != 0 || this_cpu ()->id != 0)
+		return;
+
+	next = thread_next_wakeup (ticks + oneshot_max_ticks);
+	delta = next - ticks;
+	if (delta <= 1) // 바로 다음 틱에 할 일이 있으면 그냥 주기 모드로 둔다.
+		return;
+
+	/* 현재 틱 주기의 남은 카운트에 나머지 틱들을 더한다. */
+	left = tick_left ();
+	if (left == 0 || left > tick_count)
+		left = tick_count;
+	tick_oneshot (left + (delta - 1) * tick_count);
+	oneshot_ticks = delta;
+}
+
+/* Called with interrupts off when the idle thread wakes up, and
+   by schedule() whenever it switches away from the idle thread,
+   so that no thread runs with the one-shot still armed.  If an
+   interrupt other than the timer woke the CPU, brings `ticks' up
+   to date and cuts the one-shot short at the next tick boundary.
+   The timer interrupt at that boundary does the per-tick work for
+   the ticks that went by and puts the timer back into periodic
+   mode, so the running thread loses at most part of one tick. */
+void
+timer_idle_exit (void) {
+	int64_t passed;
+	uint32_t left;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (oneshot_ticks == 0 || this_cpu ()->id != 0) // 원샷은 BSP에만 걸린다.
+		return;
+
+	/* 이미 만료되었으면 대기 중인 타이머 인터럽트가 모두 처리한다. */
+	if (tick_expired ())
+		return;
+
+	/* 남은 카운트로 지나간 틱 경계의 수를 구한다. */
+	left = tick_left ();
+	passed = oneshot_ticks - DIV_ROUND_UP (left, tick_count);
+	if (passed > 0) {
+		ticks += passed;
+		skipped_ticks += passed;
+		publish_ticks ();
+	}
+
+	left %= tick_count;
+	tick_oneshot (left != 0 ? left : tick_count);
+	oneshot_ticks = 1;
+}
+
+/* Copies `ticks' into the clock page user programs read. */
+static void
+publish_ticks (void) {
+#ifdef USERPROG
+	if (vdso_time != NULL)
+		vdso_time->ticks = ticks;
+#endif
+}
+
+/* Makes the active timer interrupt every tick. */
+static void
+tick_periodic (void) {
+	if (use_lapic)
+		lapic_timer_periodic (tick_count);
+	else
+		pit_periodic ();
+}
+
+/* Makes the active timer interrupt once, COUNT counts from now. */
+static void
+tick_oneshot (uint32_t count) {
+	if (use_lapic)
+		lapic_timer_oneshot (count);
+	else
+		pit_oneshot (count);
+}
+
+/* Returns true if the one-shot armed by tick_oneshot() has gone
+   off. */
+static bool
+tick_expired (void) {
+	return use_lapic ? lapic_timer_count () == 0 : pit_expired ();
+}
+
+/* Returns the counts left until the active timer next goes off. */
+static uint32_t
+tick_left (void) {
+	return use_lapic ? lapic_timer_count () : pit_read ();
+}
+
+/* Programs counter 0 to interrupt every tick. */
+static void
+pit_periodic (void) {
+	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
+	outb (0x40, PIT_TICK_COUNT & 0xff);
+	outb (0x40, PIT_TICK_COUNT >> 8);
+}
+
+/* Programs counter 0 to interrupt once, COUNT input clocks from
+   now. */
+static void
+pit_oneshot (uint16_t count) {
+	outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+}
+
+/* Returns true if counter 0, armed by pit_oneshot(), has reached
+   terminal count. */
+static bool
+pit_expired (void) {
+	outb (0x43, 0xe2);    /* Read-back: latch status of counter 0. */
+	return (inb (0x40) & 0x80) != 0;   /* OUT pin goes high at terminal count. */
+}
+
+/* Returns the current value of counter 0. */
+static uint16_t
+pit_read (void) {
+	uint8_t lo, hi;
+
+	outb (0x43, 0x00);    /* CW: latch counter 0. */
+	lo = inb (0x40);
+	hi = inb (0x40);
+	return lo | (hi << 8);
+}
+
+/* Measures the TSC frequency against TSC_CALIBRATE_TICKS timer
+   ticks and starts timer_ns() on the TSC.  Both ends of the
+   measurement sit on tick boundaries, so timer_ns() carries on
+   from the tick-based value without going backward. */
+static void
+calibrate_tsc (void) {
+	int64_t start;
+	uint64_t tsc_start, tsc_end;
+
+	ASSERT (intr_get_level () == INTR_ON);
 
-	if (get_global_ticks() <= ticks){ // 현재 시각이 글로벌 틱보다 크면 스레드 깨우기
-		thread_awake(ticks);
+	/* Wait for a timer tick. */
+	start = ticks;
+	while (ticks == start)
+		barrier ();
+	start = ticks;
+	tsc_start = rdtsc ();
+
+	while (ticks < start + TSC_CALIBRATE_TICKS)
+		barrier ();
+	tsc_end = rdtsc ();
+
+	tsc_hz = (tsc_end - tsc_start) * TIMER_FREQ / TSC_CALIBRATE_TICKS;
+	ASSERT (tsc_hz > 0);
+
+	enum intr_level old_level = intr_disable ();
+	tsc_base = tsc_end;
+	tsc_ns_base = (start + TSC_CALIBRATE_TICKS) * (NSEC_PER_SEC / TIMER_FREQ);
+	tsc_ns_mult = (NSEC_PER_SEC << 32) / tsc_hz;
+#ifdef USERPROG
+	if (vdso_time != NULL) { // 배율은 마지막에 써서 유저가 반쯤 쓰인 값을 보지 않게 한다.
+		vdso_time->tsc_hz = tsc_hz;
+		vdso_time->tsc_base = tsc_base;
+		vdso_time->tsc_ns_base = tsc_ns_base;
+		barrier ();
+		vdso_time->tsc_ns_mult = tsc_ns_mult;
 	}
+#endif
+	intr_set_level (old_level);
+}
+
+/* Measures the local APIC timer against TSC_CALIBRATE_TICKS ticks
+   of the 8254, then moves the tick over to it on a tick boundary
+   and masks the 8254's interrupt.  Keeps the 8254 if there is no
+   local APIC. */
+static void
+calibrate_lapic (void) {
+	enum intr_level old_level;
+	uint32_t count;
+	int64_t start;
+
+	ASSERT (intr_get_level () == INTR_ON);
+	if (!lapic_present ())
+		return;
+
+	/* Wait for a timer tick. */
+	start = ticks;
+	while (ticks == start)
+		barrier ();
+	start = ticks;
+	lapic_timer_oneshot (UINT32_MAX);
+
+	while (ticks < start + TSC_CALIBRATE_TICKS)
+		barrier ();
+	count = UINT32_MAX - lapic_timer_count ();
+	lapic_timer_stop ();
+
+	count /= TSC_CALIBRATE_TICKS;
+	if (count == 0)
+		return;
+
+	/* 다음 틱 직후, 유휴 스레드의 원샷이 걸려 있지 않을 때 넘긴다. */
+	start = ticks;
+	for (;;) {
+		old_level = intr_disable ();
+		if (ticks != start && oneshot_ticks == 0)
+			break;
+		intr_set_level (old_level);
+	}
+	intr_mask_ext (0x20);
+	intr_register_ext (LAPIC_TIMER_VEC, timer_interrupt, "LAPIC Timer");
+	use_lapic = true;
+	tick_count = count;
+	oneshot_max_ticks = UINT32_MAX / tick_count;
+	tick_periodic ();
+	intr_set_level (old_level);
+
+	printf ("Local APIC timer: %'"PRIu32" counts/tick.\n", tick_count);
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -136,7 +136,10 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	if (*name == '\0' || strlen (name) > NAME_MAX)
 		return false;
 
-	/* Check that NAME is not in use. */
+	/* Check that NAME is not in use.  The directory stays locked
+	 * until the new entry is written, so that two threads cannot
+	 * add the same NAME or take the same free slot. */
+	inode_dir_lock (dir->inode);
 	if (lookup (dir, name, NULL, NULL))
 		goto done;
 
@@ -159,6 +162,7 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 
 done:
+	inode_dir_unlock (dir->inode);
 	return success;
 }
 
@@ -176,6 +180,7 @@ dir_remove (struct dir *dir, const char *name) {
 	ASSERT (name != NULL);
 
 	/* Find directory entry. */
+	inode_dir_lock (dir->inode);
 	if (!lookup (dir, name, &e, &ofs))
 		goto done;
 
@@ -194,6 +199,7 @@ dir_remove (struct dir *dir, const char *name) {
 	success = true;
 
 done:
+	inode_dir_unlock (dir->inode);
 	inode_close (inode);
 	return success;
 }
@@ -153,6 +153,9 @@ fat_boot_create (void) {
 void
 fat_fs_init (void) {
 	/* TODO: Your code goes here. */
+	/* FAT 할당(fat_create_chain, fat_remove_chain)은 free map과 같이
+	 * inode 락과 별개인 이 락으로 보호한다. */
+	lock_init (&fat_fs->write_lock);
 }
 
 /*----------------------------------------------------------------------------*/
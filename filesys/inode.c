@@ -6,6 +6,8 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -26,13 +28,21 @@ bytes_to_sectors (off_t size) {
 	return DIV_ROUND_UP (size, DISK_SECTOR_SIZE);
 }
 
-/* In-memory inode. */
+/* In-memory inode.
+
+   ELEM, OPEN_CNT and REMOVED are protected by open_inodes_lock.
+   The file's contents and DENY_WRITE_CNT are protected by RWLOCK:
+   readers of the same inode run in parallel, writers run alone.
+   DIR_LOCK serializes updates to a directory's entries, which
+   read and then write the directory (see dir_add()). */
 struct inode {
 	struct list_elem elem;              /* Element in inode list. */
 	disk_sector_t sector;               /* Sector number of disk location. */
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	struct rwlock rwlock;               /* Protects the contents. */
+	struct lock dir_lock;               /* Serializes directory updates. */
 	struct inode_disk data;             /* Inode content. */
 };
 
@@ -53,10 +63,29 @@ byte_to_sector (const struct inode *inode, off_t pos) {
  * returns the same `struct inode'. */
 static struct list open_inodes;
 
+/*------------------------- [P4] Synchronization --------------------------*/
+/* Protects open_inodes and each inode's open_cnt and removed. */
+static struct lock open_inodes_lock;
+
+/*------------------------- [P3] Slab Allocator --------------------------*/
+/* Cache of struct inode.  An inode's locks are initialized once,
+   by inode_ctor(), and are free again by the time it is closed. */
+static struct kmem_cache *inode_cache;
+
+static void
+inode_ctor (void *obj) {
+	struct inode *inode = obj;
+
+	rwlock_init (&inode->rwlock);
+	lock_init (&inode->dir_lock);
+}
+
 /* Initializes the inode module. */
 void
 inode_init (void) {
 	list_init (&open_inodes);
+	lock_init (&open_inodes_lock);
+	inode_cache = kmem_cache_create ("inode", sizeof (struct inode), inode_ctor);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -104,36 +133,46 @@ inode_open (disk_sector_t sector) {
 	struct list_elem *e;
 	struct inode *inode;
 
+	lock_acquire (&open_inodes_lock);
+
 	/* Check whether this inode is already open. */
 	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
 			e = list_next (e)) {
 		inode = list_entry (e, struct inode, elem);
 		if (inode->sector == sector) {
-			inode_reopen (inode);
+			inode->open_cnt++;
+			lock_release (&open_inodes_lock);
 			return inode; 
 		}
 	}
 
 	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
-	if (inode == NULL)
+	inode = kmem_cache_alloc (inode_cache);
+	if (inode == NULL) {
+		lock_release (&open_inodes_lock);
 		return NULL;
+	}
 
-	/* Initialize. */
+	/* Initialize.  The inode is read while holding the lock so that
+	 * nobody else finds it in the list half-initialized. */
 	list_push_front (&open_inodes, &inode->elem);
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
 	disk_read (filesys_disk, inode->sector, &inode->data);
+	lock_release (&open_inodes_lock);
 	return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire (&open_inodes_lock);
 		inode->open_cnt++;
+		lock_release (&open_inodes_lock);
+	}
 	return inode;
 }
 
@@ -153,10 +192,13 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
+	lock_acquire (&open_inodes_lock);
+	bool last = --inode->open_cnt == 0;
+	if (last) /* Remove from inode list and release lock. */
 		list_remove (&inode->elem);
+	lock_release (&open_inodes_lock);
 
+	if (last) {
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
 			free_map_release (inode->sector, 1);
@@ -164,7 +206,7 @@ inode_close (struct inode *inode) {
 					bytes_to_sectors (inode->data.length)); 
 		}
 
-		free (inode); 
+		kmem_cache_free (inode_cache, inode);
 	}
 }
 
@@ -173,7 +215,9 @@ inode_close (struct inode *inode) {
 void
 inode_remove (struct inode *inode) {
 	ASSERT (inode != NULL);
+	lock_acquire (&open_inodes_lock);
 	inode->removed = true;
+	lock_release (&open_inodes_lock);
 }
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
@@ -185,6 +229,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	off_t bytes_read = 0;
 	uint8_t *bounce = NULL;
 
+	rwlock_acquire_read (&inode->rwlock);
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -220,6 +265,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
+	rwlock_release_read (&inode->rwlock);
 	free (bounce);
 
 	return bytes_read;
@@ -237,9 +283,17 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	off_t bytes_written = 0;
 	uint8_t *bounce = NULL;
 
+	/* Checked again below, but this avoids waiting for readers just
+	 * to find out that the write is denied (e.g. running executables). */
 	if (inode->deny_write_cnt)
 		return 0;
 
+	rwlock_acquire_write (&inode->rwlock);
+	if (inode->deny_write_cnt) {
+		rwlock_release_write (&inode->rwlock);
+		return 0;
+	}
+
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -282,6 +336,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
+	rwlock_release_write (&inode->rwlock);
 	free (bounce);
 
 	return bytes_written;
@@ -292,8 +347,10 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	void
 inode_deny_write (struct inode *inode) 
 {
+	rwlock_acquire_write (&inode->rwlock);
 	inode->deny_write_cnt++;
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
+	rwlock_release_write (&inode->rwlock);
 }
 
 /* Re-enables writes to INODE.
@@ -301,9 +358,24 @@ inode_deny_write (struct inode *inode)
  * inode_deny_write() on the inode, before closing the inode. */
 void
 inode_allow_write (struct inode *inode) {
+	rwlock_acquire_write (&inode->rwlock);
 	ASSERT (inode->deny_write_cnt > 0);
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
 	inode->deny_write_cnt--;
+	rwlock_release_write (&inode->rwlock);
+}
+
+/* Locks INODE, a directory, against concurrent updates of its
+ * entries.  Lookups do not need this lock. */
+void
+inode_dir_lock (struct inode *inode) {
+	lock_acquire (&inode->dir_lock);
+}
+
+/* Unlocks INODE, locked with inode_dir_lock(). */
+void
+inode_dir_unlock (struct inode *inode) {
+	lock_release (&inode->dir_lock);
 }
 
 /* Returns the length, in bytes, of INODE's data. */
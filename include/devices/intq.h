@@ -1,23 +1,35 @@
 #ifndef DEVICES_INTQ_H
 #define DEVICES_INTQ_H
 
+#include <stddef.h>
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 
 /* An "interrupt queue", a circular buffer shared between
    kernel threads and external interrupt handlers.
 
-   Interrupt queue functions can be called from kernel threads or
-   from external interrupt handlers.  Except for intq_init(),
-   interrupts must be off in either case.
-
-   The interrupt queue has the structure of a "monitor".  Locks
-   and condition variables from threads/synch.h cannot be used in
-   this case, as they normally would, because they can only
-   protect kernel threads from one another, not from interrupt
-   handlers. */
-
-/* Queue buffer size, in bytes. */
+   The queue is a single-producer, single-consumer ring: at any
+   time at most one caller may be adding bytes and at most one
+   may be removing them, but the two sides need no lock between
+   them.  The producer only writes HEAD and the consumer only
+   writes TAIL, and both count bytes ever added or removed, so
+   no byte of the buffer is wasted to tell full from empty.
+   Callers that can have several producers or consumers, such as
+   serial_putc(), must serialize them themselves.
+
+   Adding and removing bytes does not need interrupts off, so a
+   kernel thread can drain a queue that an interrupt handler
+   fills, or the other way around.  Only a thread that has to
+   sleep until the queue changes turns interrupts off, briefly,
+   so that the interrupt handler cannot slip in between its last
+   check and thread_block().
+
+   Locks and condition variables from threads/synch.h cannot be
+   used for that wait, as they normally would, because they can
+   only protect kernel threads from one another, not from
+   interrupt handlers. */
+
+/* Default queue buffer size, in bytes. */
 #define INTQ_BUFSIZE 64
 
 /* A circular queue of bytes. */
@@ -28,15 +40,19 @@ struct intq {
 	struct thread *not_empty;   /* Thread waiting for not-empty condition. */
 
 	/* Queue. */
-	uint8_t buf[INTQ_BUFSIZE];  /* Buffer. */
-	int head;                   /* New data is written here. */
-	int tail;                   /* Old data is read here. */
+	uint8_t *buf;               /* Buffer, SIZE bytes. */
+	size_t size;                /* Capacity, a power of 2. */
+	volatile size_t head;       /* Bytes ever added; new data goes here. */
+	volatile size_t tail;       /* Bytes ever removed; old data is read here. */
 };
 
-void intq_init (struct intq *);
+void intq_init (struct intq *, uint8_t *buf, size_t size);
 bool intq_empty (const struct intq *);
 bool intq_full (const struct intq *);
+size_t intq_count (const struct intq *);
 uint8_t intq_getc (struct intq *);
 void intq_putc (struct intq *, uint8_t);
+size_t intq_get_many (struct intq *, uint8_t *, size_t cnt);
+size_t intq_put_many (struct intq *, const uint8_t *, size_t cnt);
 
 #endif /* devices/intq.h */
@@ -2,22 +2,38 @@
 #define DEVICES_TIMER_H
 
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* Nanoseconds per second. */
+#define NSEC_PER_SEC 1000000000ULL
+
 void timer_init (void);
 void timer_calibrate (void);
+void timer_init_ap (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
 
+uint64_t timer_ns (void);
+uint64_t timer_tsc_hz (void);
+
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
 
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
+extern bool timer_tickless;
+
 void timer_print_stats (void);
+int64_t timer_interrupts (void);
+uint64_t timer_max_tick_cycles (void);
+void timer_reset_max_tick_cycles (void);
 
 #endif /* devices/timer.h */
@@ -0,0 +1,71 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Priority queue.
+ *
+ * This is a pairing heap.  Like the lists in list.h, it does not
+ * allocate memory: each structure that can be in a heap embeds a
+ * struct heap_elem member, and heap_entry() converts a struct
+ * heap_elem back to the structure that contains it.
+ *
+ * The heap keeps its largest element, as ordered by the
+ * heap_less_func given to heap_init(), on top.  Elements that
+ * compare equal come out in the order they were pushed.
+ *
+ * heap_push() and heap_top() take constant time; heap_pop(),
+ * heap_remove() and heap_update() take O(log n) amortized time.
+ *
+ * An element whose sort key changes while it is in a heap must be
+ * passed to heap_update(), or the heap stops working. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *child;    /* Leftmost child. */
+	struct heap_elem *sibling;  /* Next sibling to the right. */
+	struct heap_elem *prev;     /* Parent if leftmost child, otherwise
+	                               left sibling; null for the root and
+	                               for elements not in a heap. */
+	unsigned seq;               /* Push order, to break ties. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+	((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->child    \
+		- offsetof (STRUCT, MEMBER.child)))
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+                             const struct heap_elem *b,
+                             void *aux);
+
+/* Heap. */
+struct heap {
+	struct heap_elem *root;     /* Largest element, or null if empty. */
+	size_t size;                /* Number of elements. */
+	unsigned next_seq;          /* Sequence number for the next push. */
+	heap_less_func *less;       /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+void heap_push (struct heap *, struct heap_elem *);
+struct heap_elem *heap_top (struct heap *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_update (struct heap *, struct heap_elem *);
+
+size_t heap_size (struct heap *);
+bool heap_empty (struct heap *);
+bool heap_contains (struct heap *, struct heap_elem *);
+
+#endif /* lib/kernel/heap.h */
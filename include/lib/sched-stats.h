@@ -0,0 +1,25 @@
+#ifndef __LIB_SCHED_STATS_H
+#define __LIB_SCHED_STATS_H
+
+#include <stdint.h>
+
+/* Scheduling statistics of one thread, as kept by the kernel and
+   returned by the sched_stats() system call.
+
+   Run queue wait is the time from a thread becoming ready to it
+   actually running.  Bucket 0 of the histogram counts waits under
+   1 us, bucket N counts waits of 2^(N-1) us up to 2^N us, and the
+   last bucket also holds everything longer. */
+#define SCHED_HIST_BUCKETS 20
+
+struct sched_stats {
+	int64_t user_ticks;                 /* Ticks in user mode. */
+	int64_t kernel_ticks;               /* Ticks in kernel mode. */
+	int64_t voluntary_switches;         /* Switches away by blocking. */
+	int64_t involuntary_switches;       /* Switches away while ready. */
+	uint64_t runq_wait_ns;              /* Total run queue wait. */
+	uint64_t runq_wait_max_ns;          /* Longest run queue wait. */
+	uint32_t runq_wait_hist[SCHED_HIST_BUCKETS];
+};
+
+#endif /* lib/sched-stats.h */
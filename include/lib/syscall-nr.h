@@ -36,6 +36,17 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extra: user-space synchronization. */
+	SYS_FUTEX,                  /* Sleep on or wake a futex word. */
+
+	/* Extra: high-resolution time. */
+	SYS_CLOCK_NS,               /* Nanoseconds since boot. */
+	SYS_SCHED_STATS,            /* Scheduling statistics of a process. */
 };
 
+/* Operations for SYS_FUTEX. */
+#define FUTEX_WAIT 0                /* Sleep if the word holds a value. */
+#define FUTEX_WAKE 1                /* Wake up to a number of sleepers. */
+
 #endif /* lib/syscall-nr.h */
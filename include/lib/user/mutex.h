@@ -0,0 +1,26 @@
+#ifndef __LIB_USER_MUTEX_H
+#define __LIB_USER_MUTEX_H
+
+#include <stdbool.h>
+
+/* A lock built on the futex() system call.  Taking a free lock or
+   releasing one that nobody waits for is a single atomic
+   instruction in user mode; only a process that has to wait, and
+   the one that hands the lock to it, enter the kernel.  The lock
+   must live in memory that every process using it maps. */
+struct mutex {
+	int state;                  /* MUTEX_FREE, _LOCKED or _CONTENDED. */
+};
+
+#define MUTEX_FREE 0                /* Not held. */
+#define MUTEX_LOCKED 1              /* Held, nobody sleeping on it. */
+#define MUTEX_CONTENDED 2           /* Held, sleepers may be waiting. */
+
+#define MUTEX_INITIALIZER { MUTEX_FREE }
+
+void mutex_init (struct mutex *);
+void mutex_lock (struct mutex *);
+bool mutex_trylock (struct mutex *);
+void mutex_unlock (struct mutex *);
+
+#endif /* lib/user/mutex.h */
@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <sched-stats.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -38,6 +40,13 @@ void close (int fd);
 
 int dup2(int oldfd, int newfd);
 
+/* Extra: user-space synchronization. */
+int futex (int *uaddr, int op, int val);
+
+/* Extra: high-resolution time. */
+uint64_t clock_ns (void);
+int sched_stats (pid_t pid, struct sched_stats *stats);
+
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
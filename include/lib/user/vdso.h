@@ -0,0 +1,15 @@
+#ifndef __LIB_USER_VDSO_H
+#define __LIB_USER_VDSO_H
+
+#include <stdint.h>
+#include <syscall.h>
+
+/* Values the kernel keeps in read-only pages mapped into every
+   process (see lib/vdso-data.h).  Reading them costs a memory
+   load, not a system call. */
+int64_t vdso_ticks (void);
+uint64_t vdso_clock_ns (void);
+pid_t vdso_getpid (void);
+int vdso_cpu (void);
+
+#endif /* lib/user/vdso.h */
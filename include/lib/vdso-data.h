@@ -0,0 +1,35 @@
+#ifndef __LIB_VDSO_DATA_H
+#define __LIB_VDSO_DATA_H
+
+#include <stdint.h>
+
+/* Kernel data pages mapped read-only into every user process.
+
+   The kernel keeps frequently polled values here so that user
+   programs can read them with a plain memory load instead of a
+   system call.  The first page is shared by all processes and
+   holds the clock; the second is private to each process. */
+
+/* User virtual addresses of the two pages. */
+#define VDSO_ADDR 0x7000000000ULL
+#define VDSO_PROC_ADDR (VDSO_ADDR + 4096)
+#define VDSO_END (VDSO_PROC_ADDR + 4096)   /* One past the last byte. */
+
+/* Shared by all processes. */
+struct vdso_time {
+	volatile int64_t ticks;             /* Timer ticks since boot. */
+	volatile uint64_t tsc_base;         /* TSC at tsc_ns_base. */
+	volatile uint64_t tsc_ns_base;      /* Nanoseconds since boot at tsc_base. */
+	volatile uint64_t tsc_ns_mult;      /* Nanoseconds per TSC cycle, 32.32
+	                                       fixed point, 0 until calibrated. */
+	volatile uint64_t tsc_hz;           /* TSC cycles per second. */
+	uint32_t timer_freq;                /* Timer ticks per second. */
+};
+
+/* Private to one process. */
+struct vdso_proc {
+	volatile int pid;                   /* Process identifier. */
+	volatile int cpu;                   /* CPU the process last ran on. */
+};
+
+#endif /* lib/vdso-data.h */
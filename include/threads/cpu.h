@@ -0,0 +1,64 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sched-stats.h>
+#include "threads/spinlock.h"
+
+/*------------------------- [P1] SMP --------------------------*/
+/* Maximum number of CPUs the kernel keeps per-CPU state for. */
+#define NCPU_MAX 8
+
+/* Number of priority levels in a run queue.  Must match
+   PRI_MAX - PRI_MIN + 1 in threads/thread.h. */
+#define RQ_LEVELS 64
+
+/* A CPU's run queue: one FIFO list of THREAD_READY threads per
+   priority, plus a bitmap whose bit N is set iff queues[N] is
+   non-empty.  Owned by thread.c. */
+struct runqueue {
+	struct spinlock lock;               /* Protects the fields below. */
+	struct list queues[RQ_LEVELS];      /* Ready threads, by priority. */
+	uint64_t bitmap;                    /* Non-empty queues. */
+	int cnt;                            /* # of threads in queues. */
+};
+
+/* Per-CPU state. */
+struct cpu {
+	int id;                             /* Index in cpus[]. */
+	uint8_t apic_id;                    /* Local APIC ID. */
+	bool online;                        /* Running kernel code? */
+
+	/* Owned by thread.c. */
+	struct runqueue rq;                 /* Threads ready to run here. */
+	struct thread *idle_thread;         /* Runs when rq is empty. */
+	struct thread *curr;                /* Thread running here. */
+	struct thread *switched_from;       /* Thread whose switch is finishing. */
+	struct list dying;                  /* Exited threads to free. */
+	unsigned thread_ticks;              /* # of ticks since last yield. */
+	long long idle_ticks;               /* # of ticks spent idle. */
+	long long kernel_ticks;             /* # of ticks in kernel threads. */
+	long long user_ticks;               /* # of ticks in user programs. */
+	long long steals;                   /* # of successful work steals. */
+	long long migrations;               /* # of threads stolen from others. */
+	long long switches;                 /* # of context switches. */
+	bool yield_deferred;                /* Yield once interrupts are back on? */
+	struct sched_stats sched;           /* Totals over threads run here. */
+
+	/* Owned by interrupt.c. */
+	bool in_external_intr;              /* Handling an external interrupt? */
+	bool yield_on_return;               /* Yield on interrupt return? */
+};
+
+/* All CPUs found at boot.  cpus[0] is the bootstrap processor. */
+extern struct cpu cpus[NCPU_MAX];
+extern int cpu_cnt;
+
+void cpu_init (void);
+void cpu_start_aps (void);
+struct cpu *this_cpu (void);
+int cpu_online_cnt (void);
+
+#endif /* threads/cpu.h */
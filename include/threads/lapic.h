@@ -0,0 +1,29 @@
+#ifndef THREADS_LAPIC_H
+#define THREADS_LAPIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*------------------------- [P1] Local APIC --------------------------*/
+/* Interrupt vectors raised by the local APIC.  Vectors from
+   LAPIC_TIMER_VEC up to, but not including, LAPIC_SPURIOUS_VEC
+   are external interrupts that lapic_eoi() acknowledges. */
+#define LAPIC_TIMER_VEC 0xf0        /* Local APIC timer. */
+#define LAPIC_RESCHED_VEC 0xf1      /* Run queue changed (see thread.c). */
+#define LAPIC_SPURIOUS_VEC 0xff     /* Spurious interrupt, never acknowledged. */
+
+void lapic_init (void);
+bool lapic_present (void);
+uint8_t lapic_id (void);
+void lapic_eoi (void);
+
+void lapic_timer_periodic (uint32_t count);
+void lapic_timer_oneshot (uint32_t count);
+void lapic_timer_stop (void);
+uint32_t lapic_timer_count (void);
+
+void lapic_send_ipi (uint8_t apic_id, uint8_t vec);
+void lapic_send_init (uint8_t apic_id);
+void lapic_send_startup (uint8_t apic_id, uint64_t pa);
+
+#endif /* threads/lapic.h */
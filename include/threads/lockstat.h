@@ -0,0 +1,35 @@
+#ifndef THREADS_LOCKSTAT_H
+#define THREADS_LOCKSTAT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*------------------------- [P1] Lock Profiling --------------------------*/
+/* Contention statistics for one class of locks or semaphores.
+
+   Every lock initialized by the same lock_init() expression, e.g.
+   "&tid_lock" or "&inode->dir_lock", shares one class, so that
+   per-object locks and locks on the stack add up instead of
+   filling the table.  Classes are only created when profiling is
+   enabled with the -lockstat kernel option. */
+struct lock_class {
+	const char *name;                   /* lock_init() / sema_init() argument. */
+	bool is_sema;                       /* Semaphore rather than lock? */
+	long long acquired;                 /* # of acquisitions (sema_down). */
+	long long contended;                /* # of acquisitions that waited. */
+	int64_t wait_ticks;                 /* Total ticks spent waiting. */
+	int64_t max_wait_ticks;             /* Longest wait. */
+	int64_t max_hold_ticks;             /* Longest hold (locks only). */
+	int last_contender;                 /* tid of the last thread that waited. */
+	char last_contender_name[16];       /* Its name. */
+};
+
+/* -lockstat: Collect lock contention statistics? */
+extern bool lockstat_enabled;
+
+struct lock_class *lockstat_register (const char *name, bool is_sema);
+void lockstat_acquired (struct lock_class *, bool contended, int64_t wait_ticks);
+void lockstat_released (struct lock_class *, int64_t hold_ticks);
+void lockstat_print_stats (void);
+
+#endif /* threads/lockstat.h */
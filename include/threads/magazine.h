@@ -0,0 +1,63 @@
+#ifndef THREADS_MAGAZINE_H
+#define THREADS_MAGAZINE_H
+
+#include <stddef.h>
+#include "threads/cpu.h"
+
+/*------------------------- [P3] Magazines --------------------------*/
+/* Per-CPU magazines of free objects.
+
+   A magazine rack sits in front of a shared store of free objects
+   (a page pool, a malloc size class, a slab cache) and gives each
+   CPU a small stack of objects of its own.  A CPU only touches its
+   own magazine, with interrupts off, so most gets and puts take no
+   lock.  When a magazine runs empty it is refilled from the store,
+   and when it is full the objects freed longest ago are drained
+   back, BATCH objects at a time; the store's callbacks take the
+   store's own lock for the whole batch. */
+
+/* Largest magazine a rack may use. */
+#define MAGAZINE_MAX 32
+
+/* Magazine size and batch for small objects, used by malloc() and
+   the object caches. */
+#define MAGAZINE_SIZE 16
+#define MAGAZINE_BATCH 8
+
+/* Moves up to CNT objects from STORE into OBJS and returns how
+   many it moved.  Called with interrupts off. */
+typedef size_t magazine_refill_func (void *store, void **objs, size_t cnt);
+
+/* Gives the CNT objects in OBJS back to STORE.  Called with
+   interrupts off. */
+typedef void magazine_drain_func (void *store, void **objs, size_t cnt);
+
+/* A CPU's magazine. */
+struct magazine {
+	void *objs[MAGAZINE_MAX];           /* Free objects, last put on top. */
+	int cnt;                            /* # of objects in OBJS. */
+	long long hits;                     /* # of gets served from OBJS. */
+	long long misses;                   /* # of gets that found OBJS empty. */
+	long long refills;                  /* # of batches taken from the store. */
+	long long drains;                   /* # of batches given back. */
+	long long puts;                     /* # of objects put into OBJS. */
+};
+
+/* One magazine per CPU in front of a store. */
+struct magazine_rack {
+	int size;                           /* Objects a magazine holds at most. */
+	int batch;                          /* Objects moved at once. */
+	magazine_refill_func *refill;
+	magazine_drain_func *drain;
+	void *store;                        /* Passed to REFILL and DRAIN. */
+	struct magazine mags[NCPU_MAX];     /* Magazines, by CPU id. */
+};
+
+void magazine_rack_init (struct magazine_rack *, int size, int batch,
+                         magazine_refill_func *, magazine_drain_func *,
+                         void *store);
+void *magazine_get (struct magazine_rack *);
+void magazine_put (struct magazine_rack *, void *);
+void magazine_rack_stats (const struct magazine_rack *, struct magazine *total);
+
+#endif /* threads/magazine.h */
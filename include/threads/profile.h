@@ -0,0 +1,39 @@
+#ifndef THREADS_PROFILE_H
+#define THREADS_PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct intr_frame;
+
+/*------------------------- [P1] Sampling Profiler --------------------------*/
+/* Sampling profiler.
+
+   With the -profile kernel option, every timer interrupt records
+   where the interrupted thread was: its rip and a few return
+   addresses found by following the frame pointer chain, in the
+   kernel or in the user program.  The "profdump" action writes
+   the samples to the scratch disk, and utils/profile symbolizes
+   them into a flat profile and folded stacks. */
+
+/* Return addresses kept per sample, including rip. */
+#define PROFILE_DEPTH 12
+
+/* One sample, as stored in the buffer and on disk. */
+struct profile_sample {
+	uint64_t pcs[PROFILE_DEPTH];        /* rip, then return addresses. */
+	int32_t tid;                        /* Interrupted thread. */
+	uint8_t depth;                      /* # of valid PCS. */
+	uint8_t user;                       /* Interrupted user code? */
+	uint16_t cpu;                       /* CPU that took the sample. */
+	char name[16];                      /* Thread name. */
+};
+
+/* -profile: Take samples? */
+extern bool profile_enabled;
+
+void profile_init (void);
+void profile_sample (const struct intr_frame *);
+void profile_dump (char **argv);
+
+#endif /* threads/profile.h */
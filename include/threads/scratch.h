@@ -0,0 +1,25 @@
+#ifndef THREADS_SCRATCH_H
+#define THREADS_SCRATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "devices/disk.h"
+
+/*------------------------- [P1] Scratch Disk Dumps --------------------------*/
+/* Writes debugging dumps (tracedump, profdump) to the scratch
+   disk, hdc or hd1:0, one after another from its beginning.  Each
+   dump starts with a sector holding "GET\0" and its size as a
+   32-bit integer, the format fsutil_get() uses, so the pintos
+   script reads them back the same way. */
+struct scratch_writer {
+	struct disk *disk;                  /* Scratch disk. */
+	disk_sector_t sector;               /* Next sector to write. */
+	uint8_t *buf;                       /* Sector being filled. */
+	size_t ofs;                         /* Bytes in BUF so far. */
+};
+
+void scratch_begin (struct scratch_writer *, size_t size);
+void scratch_write (struct scratch_writer *, const void *, size_t);
+void scratch_end (struct scratch_writer *);
+
+#endif /* threads/scratch.h */
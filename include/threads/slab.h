@@ -0,0 +1,42 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*------------------------- [P3] Slab Allocator --------------------------*/
+/* Object caches.
+
+   A cache hands out objects of one fixed size, packed into
+   page-sized slabs without rounding the size up to a power of 2
+   the way malloc() does.  Each CPU keeps a few free objects of
+   every cache, so most allocations and frees take no lock.
+
+   If a cache has a constructor, it runs once per object when
+   the object's slab is created, not on every allocation.  Objects
+   must therefore be given back in their constructed state, for
+   example with their locks released.
+
+   free() also accepts objects from a cache, so code that frees
+   them the malloc() way keeps working. */
+
+/* Initializes an object of a cache, see above. */
+typedef void kmem_ctor (void *obj);
+
+struct kmem_cache;
+
+/* -kmemstat: Print a slab memory report at power off? */
+extern bool kmemstat_enabled;
+
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+                                      kmem_ctor *);
+void *kmem_cache_alloc (struct kmem_cache *);
+void *kmem_cache_zalloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+
+bool kmem_owns (const void *);
+size_t kmem_size (const void *);
+void kmem_free (void *);
+void kmem_print_stats (void);
+
+#endif /* threads/slab.h */
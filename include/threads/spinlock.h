@@ -0,0 +1,31 @@
+#ifndef THREADS_SPINLOCK_H
+#define THREADS_SPINLOCK_H
+
+#include <stdbool.h>
+#include "threads/interrupt.h"
+
+/*------------------------- [P1] SMP --------------------------*/
+/* Spin lock.
+
+   Protects short critical sections against other CPUs as well as
+   against interrupt handlers on this CPU: spinlock_acquire()
+   turns interrupts off before spinning and returns the previous
+   interrupt level, which must be handed back to
+   spinlock_release().  This mirrors the intr_disable() /
+   intr_set_level() pairs used everywhere else in the kernel.
+
+   A spin lock must never be held across a context switch.  Code
+   that needs to sleep should release its spin lock with
+   INTR_OFF, so that interrupts stay off until thread_block()
+   has switched away, and reacquire it after waking up. */
+struct spinlock {
+	volatile unsigned locked;   /* Nonzero while held. */
+	struct cpu *cpu;            /* CPU holding the lock (for debugging). */
+};
+
+void spinlock_init (struct spinlock *);
+enum intr_level spinlock_acquire (struct spinlock *);
+void spinlock_release (struct spinlock *, enum intr_level);
+bool spinlock_held_by_current_cpu (const struct spinlock *);
+
+#endif /* threads/spinlock.h */
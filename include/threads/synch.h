@@ -1,36 +1,64 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "threads/spinlock.h"
+#include "threads/lockstat.h"
 
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* Current value. */
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiting threads, by priority. */
+	struct spinlock spin;       /* Protects value and waiters. */
+	struct lock_class *stat;    /* Contention statistics, or NULL. */
 };
 
-void sema_init (struct semaphore *, unsigned value);
+/* Semaphores and locks are named after the argument passed to
+   sema_init() or lock_init(), e.g. "&tid_lock", in the -lockstat
+   contention report. */
+#define sema_init(SEMA, VALUE) sema_init_named (SEMA, VALUE, #SEMA)
+void sema_init_named (struct semaphore *, unsigned value, const char *name);
 void sema_down (struct semaphore *);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
 
-/* Lock. */
+/* Lock.
+
+   A lock keeps its waiters in a priority heap.  While it has
+   waiters, it also sits in its holder's held_locks heap, keyed by
+   its highest waiter priority, so the priority a thread receives
+   by donation is always the top of held_locks.
+
+   lock_release() hands the lock straight to its highest-priority
+   waiter, so a running thread cannot take it back before the
+   waiter gets to run.  lock_allow_barging() turns this off for a
+   lock: the waiter is only woken up and has to compete for the
+   lock again, which lets a thread that releases and reacquires a
+   lock in a loop keep it without a context switch. */
 struct lock {
-	struct thread *holder;      /* Thread holding lock (for debugging). */
-	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	struct thread *holder;      /* Thread holding lock. */
+	struct spinlock spin;       /* Protects holder. */
+	struct heap waiters;        /* Waiting threads, by priority. */
+	struct heap_elem held_elem; /* Element in holder's held_locks. */
+	bool barging;               /* Let running threads take it first? */
+	struct lock_class *stat;    /* Contention statistics, or NULL. */
+	int64_t acquired_at;        /* Tick of acquisition, if profiled. */
 };
 
-void lock_init (struct lock *);
+#define lock_init(LOCK) lock_init_named (LOCK, #LOCK)
+void lock_init_named (struct lock *, const char *name);
+void lock_allow_barging (struct lock *);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 /*------------------------- [P1] Priority Scheduling --------------------------*/
-void donate_priority(void);
-void remove_with_lock(struct lock *);
 void refresh_priority(void);
+bool cmp_lock_priority (const struct heap_elem *a, const struct heap_elem *b, void *aux);
 
 /* Condition variable. */
 struct condition {
@@ -42,6 +70,48 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/*------------------------- [P4] Reader-Writer Lock --------------------------*/
+/* Reader-writer lock.  Any number of readers or a single writer
+   may hold it at a time.  Waiting writers are preferred: once a
+   writer is waiting, new readers wait too, so a steady stream of
+   readers cannot starve writers.
+
+   A thread that blocks on an rwlock donates its priority to the
+   writer or to every reader holding it.  To find the readers, each
+   thread records up to RWLOCK_HELD_MAX held rwlocks in its
+   rw_held[] slots; holds beyond that still work, but do not
+   receive donations. */
+#define RWLOCK_HELD_MAX 4
+
+/* One rwlock held by a thread (slot in struct thread's rw_held). */
+struct rwlock_hold {
+	struct rwlock *rwlock;      /* Held rwlock, or NULL if unused. */
+	struct thread *holder;      /* Thread this slot belongs to. */
+	struct list_elem elem;      /* Element in rwlock's holders. */
+};
+
+struct rwlock {
+	struct spinlock spin;       /* Protects the members below. */
+	int readers;                /* Number of readers holding the lock. */
+	struct thread *writer;      /* Writer holding the lock, if any. */
+	struct thread *upgrader;    /* Reader waiting in rwlock_upgrade(). */
+	int waiting_writers;        /* Number of writers in WAITERS. */
+	struct list waiters;        /* Waiting threads, by priority. */
+	struct list holders;        /* Holders' struct rwlock_hold slots. */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+bool rwlock_try_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+bool rwlock_try_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_try_upgrade (struct rwlock *);
+bool rwlock_upgrade (struct rwlock *);
+void rwlock_downgrade (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
@@ -4,8 +4,11 @@
 #include <debug.h>
 #include <list.h>
 #include <stdint.h>
+#include "threads/cpu.h"
+#include "threads/fixed_point.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "userprog/fdt.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -30,15 +33,10 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
-/*------------------------- [P2] System Call --------------------------*/
-#define FDT_PAGES 3 // fdt 할당시 필요한 페이지 개수
-#define FDCOUNT_LIMIT FDT_PAGES *(1<<9) // 3(테이블 개수) * 512(한 테이블 당 전체 엔트리 개수)
-// ↳ [comment] FDT_PAGES < 3 으로 하면 "multi-oom"테스트에서 터진다.
-/*
-	- 한 페이지 당 엔트리 개수가 512인 이유?
-		- 기본으로 설정된 페이지 하나의 사이즈 : PGSIZE(1 << 12) _ Ref. "threads/vaddr.h"
-		- PGSIZE / sizeof(struct file**)[= 8byte] = 512(개의 엔트리)
-*/
+/* Thread niceness, for the multi-level feedback queue scheduler. */
+#define NICE_MIN -20                    /* Most willing to hog the CPU. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Most willing to give it up. */
 
 /* A kernel thread or user process.
  *
@@ -92,11 +90,13 @@ typedef int tid_t;
  * set to THREAD_MAGIC.  Stack overflow will normally change this
  * value, triggering the assertion. */
 /* The `elem' member has a dual purpose.  It can be an element in
- * the run queue (thread.c), or it can be an element in a
- * semaphore wait list (synch.c).  It can be used these two ways
- * only because they are mutually exclusive: only a thread in the
- * ready state is on the run queue, whereas only a thread in the
- * blocked state is on a semaphore wait list. */
+ * the run queue (thread.c), or it can be an element in an rwlock
+ * wait list (synch.c), or a slot of the sleep timing wheel
+ * (thread.c).  It can be used these ways only because they are
+ * mutually exclusive: only a thread in the ready state is on the
+ * run queue, whereas only a blocked thread is on a wait list or
+ * sleeping.  Semaphores and locks queue their waiters through
+ * `wait_elem' instead. */
 struct thread {
 	/* Owned by thread.c. */
 	tid_t tid;                          /* Thread identifier. */
@@ -108,19 +108,39 @@ struct thread {
 	struct lock *wait_on_lock; // 해당 스레드가 대기하고 있는 lock의 주소
 	int64_t wakeup_tick; // 해당 스레드를 깨워야하는 시간(local ticks)
 
+	/*------------------------- [P1] SMP --------------------------*/
+	struct cpu *cpu;                    /* CPU running this thread, or whose
+	                                       run queue holds it. */
+	volatile bool on_cpu;               /* Running, or not yet switched away
+	                                       from?  Not stealable if so. */
+
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;              /* List element. */
 
-	struct list donations; // 해당 스레드에 priority donation 해준 스레드 리스트
-	struct list_elem d_elem; // donations 를 위한 elem
+	struct heap_elem wait_elem; // 세마포어나 락의 waiters 힙을 위한 elem
+	struct semaphore *wait_on_sema; // 해당 스레드가 대기하고 있는 세마포어의 주소
+	struct heap held_locks; // 기다리는 스레드가 있는, 잡고 있는 락들 (waiter 최고 우선순위 순)
+
+	/*------------------------- [P4] Reader-Writer Lock --------------------------*/
+	struct rwlock *wait_on_rwlock; // 해당 스레드가 대기하고 있는 rwlock의 주소
+	bool rw_want_write; // wait_on_rwlock을 쓰기 위해 기다리는지 여부
+	struct rwlock_hold rw_held[RWLOCK_HELD_MAX]; // 현재 잡고 있는 rwlock들 (donation 용)
 
+	/*------------------------- [P1] Advanced Scheduler --------------------------*/
+	int nice; // 다른 스레드에게 CPU를 양보하는 정도 (-20 ~ 20)
+	fixed_t recent_cpu; // 최근에 사용한 CPU 시간 (17.14 고정소수점)
+	int64_t recent_cpu_sec; // recent_cpu에 마지막으로 decay를 반영한 시점(초)
+
+	/*------------------------- [P1] Scheduler Accounting --------------------------*/
+	struct sched_stats stats; // CPU 사용 시간, 컨텍스트 스위치 수, 레디 큐 대기 시간
+	uint64_t ready_since; // 레디 큐에 들어간 시각(ns)
 
 /*------------------------- [P2] System Call --------------------------*/
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
 	uint64_t *pml4;                     /* Page map level 4 */
-	struct file **fdt; // 파일 디스크립터 테이블(프로세스당 개별적으로 존재)
-	int next_fd; // 다음 fd 인덱스
+	struct fdtable fdt; // 파일 디스크립터 테이블(프로세스당 개별적으로 존재, 처음 open 할 때 할당)
+	struct vdso_proc *vdso; // 유저 공간에 읽기 전용으로 매핑된 프로세스 정보 페이지 (userprog/vdso.c)
 
 	// Ref_92p. Hanyang Univ
 	struct intr_frame parent_if; // 부모 프로세스의 인터럽트 프레임
@@ -156,11 +176,21 @@ struct thread {
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* -schedstat: Print a scheduling latency report at power off? */
+extern bool thread_schedstat;
+
+/* Protects every thread's child_list and child_elem. */
+extern struct spinlock thread_child_lock;
+
 void thread_init (void);
 void thread_start (void);
+struct thread *thread_init_ap (struct cpu *);
+void thread_start_ap (void) NO_RETURN;
 
-void thread_tick (void);
+void thread_tick (int64_t tick, bool user);
+void thread_idle_tick (int64_t tick);
 void thread_print_stats (void);
+long long thread_switch_cnt (void);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
@@ -174,6 +204,9 @@ const char *thread_name (void);
 
 void thread_exit (void) NO_RETURN;
 void thread_yield (void);
+void thread_defer_yield (void);
+void thread_run_deferred_yield (void);
+bool thread_ready_waiting (void);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
@@ -182,14 +215,15 @@ int thread_get_nice (void);
 void thread_set_nice (int);
 int thread_get_recent_cpu (void);
 int thread_get_load_avg (void);
+void thread_get_stats (struct thread *, struct sched_stats *);
 
 void do_iret (struct intr_frame *tf);
 
 /*------------------------- [P1] Alarm Clock & Priority Scheduling --------------------------*/
-int64_t get_global_ticks(void);
-void set_global_ticks(int64_t ticks);
 void thread_awake(int64_t ticks);
 void thread_sleep(int64_t ticks);
+int64_t thread_next_wakeup (int64_t limit);
+void thread_change_priority (struct thread *t, int new_priority);
 bool cmp_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
 
 #endif /* threads/thread.h */
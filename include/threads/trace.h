@@ -0,0 +1,53 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*------------------------- [P1] Event Tracing --------------------------*/
+/* Binary event tracing.
+
+   With the -trace kernel option, each CPU records timestamped
+   events into its own ring buffer, overwriting the oldest ones
+   when it fills up.  Recording an event takes no lock and prints
+   nothing, so tracing disturbs timing far less than printf().
+   The "tracedump" action writes the buffers to the scratch disk,
+   and utils/trace-decode turns them back into text. */
+
+/* Event types.  utils/trace-decode knows these numbers. */
+enum trace_type {
+	TRACE_SWITCH = 1,                   /* A: previous tid, B: next tid. */
+	TRACE_PAGE_FAULT,                   /* A: fault address, B: PF_* error code. */
+	TRACE_SYSCALL_ENTER,                /* A: syscall number, B: first argument. */
+	TRACE_SYSCALL_EXIT,                 /* A: syscall number, B: return value. */
+	TRACE_DISK_ISSUE,                   /* A: disk (channel << 1 | dev), B: sector
+	                                       (bit 63 set for writes). */
+	TRACE_DISK_COMPLETE,                /* A: disk, B: sector (as above). */
+	TRACE_LOCK_CONTENDED,               /* A: lock address, B: holder tid. */
+};
+
+/* One event, as stored in the buffers and on disk. */
+struct trace_event {
+	uint64_t ns;                        /* timer_ns() when recorded. */
+	uint16_t type;                      /* enum trace_type. */
+	uint16_t cpu;                       /* CPU that recorded it. */
+	int32_t tid;                        /* Running thread. */
+	uint64_t a, b;                      /* Type-specific arguments. */
+};
+
+/* -trace: Record events? */
+extern bool trace_enabled;
+
+void trace_init (void);
+void trace_record (enum trace_type, uint64_t a, uint64_t b);
+void trace_dump (char **argv);
+
+/* Records an event of TYPE with arguments A and B, if tracing is
+   enabled.  Costs a single test otherwise. */
+static inline void
+trace_event (enum trace_type type, uint64_t a, uint64_t b) {
+	if (trace_enabled)
+		trace_record (type, a, b);
+}
+
+#endif /* threads/trace.h */
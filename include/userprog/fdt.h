@@ -0,0 +1,37 @@
+#ifndef USERPROG_FDT_H
+#define USERPROG_FDT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct file;
+
+/*------------------------- [P2] System Call --------------------------*/
+#define FDT_INIT_SIZE 16 // fdt가 처음 할당될 때의 엔트리 개수
+#define FDCOUNT_LIMIT 1536 // 프로세스 하나가 열 수 있는 fd의 최대 개수(+ stdin, stdout)
+// ↳ [comment] 1536보다 작게 하면 "multi-oom"테스트에서 터진다.
+
+/* A per-process file descriptor table.
+
+   The table starts empty and is allocated on the first open().
+   Each time it fills up it doubles, up to FDCOUNT_LIMIT entries.
+   USED has one bit per fd, and bit I of FULL is set when USED[I]
+   has no free fd left, so the lowest free fd is found with two
+   count-trailing-zeros instructions.  fd 0 and 1 (stdin, stdout)
+   are always marked used and never hold a file. */
+struct fdtable {
+	struct file **files;                /* fd -> file, NULL if free. */
+	uint64_t *used;                     /* Bitmap of fds in use. */
+	uint64_t full;                      /* Bitmap of full USED words. */
+	int size;                           /* Number of entries in FILES. */
+	int cnt;                            /* Number of open files. */
+};
+
+void fdt_init (struct fdtable *);
+int fdt_add (struct fdtable *, struct file *);
+struct file *fdt_get (struct fdtable *, int fd);
+struct file *fdt_remove (struct fdtable *, int fd);
+bool fdt_duplicate (struct fdtable *dst, struct fdtable *src);
+void fdt_destroy (struct fdtable *);
+
+#endif /* userprog/fdt.h */
@@ -0,0 +1,19 @@
+#ifndef USERPROG_FUTEX_H
+#define USERPROG_FUTEX_H
+
+/*------------------------- [P2] Futex --------------------------*/
+/* Wait queues for the futex system call.
+
+   A futex is a 32-bit word in user memory.  User programs build
+   locks on it with atomic instructions and only call into the
+   kernel to sleep until the word changes (FUTEX_WAIT) or to wake
+   up threads sleeping on it (FUTEX_WAKE).  Sleepers are keyed by
+   the kernel address of the word, that is, by the physical frame
+   behind it, so processes that map the same frame share one
+   queue however they map it. */
+
+void futex_init (void);
+int futex_wait (const int *kaddr, int val);
+int futex_wake (const int *kaddr, int cnt);
+
+#endif /* userprog/futex.h */
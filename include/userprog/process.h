@@ -10,6 +10,7 @@ int process_exec (void *f_name);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (struct thread *next);
+struct thread *get_child_process (int pid);
 
 /*-------------------------[P3]Anonoymous page---------------------------------*/
 struct segment_aux {
@@ -17,6 +18,7 @@ struct segment_aux {
     off_t offset;
     size_t page_read_bytes;
 };
+extern struct kmem_cache *segment_aux_cache; // vm/vm.c
 
 bool setup_stack (struct intr_frame *if_);
 bool lazy_load_segment (struct page *page, void *aux);
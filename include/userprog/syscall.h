@@ -4,9 +4,8 @@
 #include "threads/synch.h"
 
 void syscall_init (void);
+void syscall_init_cpu (void);
 
 void close (int fd);
 
-struct lock filesys_lock; // 파일 점유시 필요한 락
-
 #endif /* userprog/syscall.h */
@@ -0,0 +1,22 @@
+#ifndef USERPROG_VDSO_H
+#define USERPROG_VDSO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <vdso-data.h>
+
+struct thread;
+
+/*------------------------- [P2] vDSO --------------------------*/
+/* Read-only kernel data pages in user space, see lib/vdso-data.h.
+   The clock page is written by devices/timer.c. */
+
+extern struct vdso_time *vdso_time;
+
+void vdso_init (void);
+bool vdso_map (struct thread *);
+void vdso_unmap (struct thread *);
+void vdso_activate (struct thread *);
+bool vdso_overlaps (const void *, size_t);
+
+#endif /* userprog/vdso.h */
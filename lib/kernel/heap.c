@@ -0,0 +1,186 @@
+#include "heap.h"
+#include "../debug.h"
+
+/* A pairing heap is a tree in which every element is at least as
+   large as its children.  Each element points to its leftmost
+   child, and the children of an element form a list through
+   their `sibling' links.  The `prev' link goes back to the left
+   sibling, or to the parent for a leftmost child, so that any
+   element can be cut out of the tree in constant time.
+
+   Two trees are melded by making the root with the smaller value
+   the leftmost child of the other one.  Popping the root melds
+   its children back into one tree in two passes: first pairs of
+   neighbours left to right, then the results right to left.
+   This second step is what keeps the amortized cost of a pop
+   logarithmic. */
+
+/* Returns true if A should come out of HEAP before B. */
+static inline bool
+outranks (struct heap *heap, struct heap_elem *a, struct heap_elem *b) {
+	if (heap->less (b, a, heap->aux))
+		return true;
+	if (heap->less (a, b, heap->aux))
+		return false;
+	return (int) (a->seq - b->seq) < 0; // 같으면 먼저 들어온 원소가 먼저 나온다.
+}
+
+/* Melds the trees rooted at A and B, either of which may be
+   null, and returns the root of the result.  A and B must have
+   no siblings and no parent. */
+static struct heap_elem *
+meld (struct heap *heap, struct heap_elem *a, struct heap_elem *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+	if (outranks (heap, b, a)) {
+		struct heap_elem *t = a;
+		a = b;
+		b = t;
+	}
+
+	b->prev = a;
+	b->sibling = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	return a;
+}
+
+/* Melds FIRST and all of its right siblings into a single tree
+   and returns its root, or a null pointer if FIRST is null. */
+static struct heap_elem *
+merge_pairs (struct heap *heap, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;
+	struct heap_elem *root = NULL;
+
+	/* Left to right: meld neighbours pairwise, stacking the
+	   results on PAIRS through their sibling links. */
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->sibling;
+
+		first = b != NULL ? b->sibling : NULL;
+		a->prev = a->sibling = NULL;
+		if (b != NULL)
+			b->prev = b->sibling = NULL;
+
+		a = meld (heap, a, b);
+		a->sibling = pairs;
+		pairs = a;
+	}
+
+	/* Right to left: meld each pair into the result. */
+	while (pairs != NULL) {
+		struct heap_elem *next = pairs->sibling;
+		pairs->sibling = NULL;
+		root = meld (heap, root, pairs);
+		pairs = next;
+	}
+	return root;
+}
+
+/* Cuts ELEM, which must not be HEAP's root, and its subtree out
+   of its parent's list of children. */
+static void
+cut (struct heap_elem *elem) {
+	ASSERT (elem->prev != NULL);
+
+	if (elem->prev->child == elem)
+		elem->prev->child = elem->sibling;
+	else
+		elem->prev->sibling = elem->sibling;
+	if (elem->sibling != NULL)
+		elem->sibling->prev = elem->prev;
+	elem->prev = elem->sibling = NULL;
+}
+
+/* Initializes HEAP as an empty heap ordered by LESS given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *heap, heap_less_func *less, void *aux) {
+	ASSERT (heap != NULL);
+	ASSERT (less != NULL);
+
+	heap->root = NULL;
+	heap->size = 0;
+	heap->next_seq = 0;
+	heap->less = less;
+	heap->aux = aux;
+}
+
+/* Inserts ELEM, which must not be in any heap, into HEAP. */
+void
+heap_push (struct heap *heap, struct heap_elem *elem) {
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+
+	elem->child = elem->sibling = elem->prev = NULL;
+	elem->seq = heap->next_seq++;
+	heap->root = meld (heap, heap->root, elem);
+	heap->size++;
+}
+
+/* Returns the largest element in HEAP.  Undefined behavior if
+   HEAP is empty. */
+struct heap_elem *
+heap_top (struct heap *heap) {
+	ASSERT (!heap_empty (heap));
+	return heap->root;
+}
+
+/* Removes the largest element from HEAP and returns it.
+   Undefined behavior if HEAP is empty. */
+struct heap_elem *
+heap_pop (struct heap *heap) {
+	struct heap_elem *top = heap_top (heap);
+
+	heap->root = merge_pairs (heap, top->child);
+	heap->size--;
+	top->child = NULL;
+	return top;
+}
+
+/* Removes ELEM, which must be in HEAP, from HEAP. */
+void
+heap_remove (struct heap *heap, struct heap_elem *elem) {
+	ASSERT (heap_contains (heap, elem));
+
+	if (elem == heap->root) {
+		heap_pop (heap);
+		return;
+	}
+	cut (elem);
+	heap->root = meld (heap, heap->root, merge_pairs (heap, elem->child));
+	heap->size--;
+	elem->child = NULL;
+}
+
+/* Restores HEAP's order after the sort key of ELEM, which must be
+   in HEAP, changed.  ELEM goes behind the elements that compare
+   equal to it. */
+void
+heap_update (struct heap *heap, struct heap_elem *elem) {
+	heap_remove (heap, elem);
+	heap_push (heap, elem);
+}
+
+/* Returns the number of elements in HEAP. */
+size_t
+heap_size (struct heap *heap) {
+	return heap->size;
+}
+
+/* Returns true if HEAP is empty, false otherwise. */
+bool
+heap_empty (struct heap *heap) {
+	return heap->root == NULL;
+}
+
+/* Returns true if ELEM is in HEAP, false if it is in no heap at
+   all.  ELEM must not be in any other heap. */
+bool
+heap_contains (struct heap *heap, struct heap_elem *elem) {
+	return elem == heap->root || elem->prev != NULL;
+}
@@ -0,0 +1,52 @@
+#include <mutex.h>
+#include <syscall.h>
+#include <syscall-nr.h>
+
+/* The three-state lock from Drepper, "Futexes Are Tricky".  A
+   holder that sees MUTEX_CONTENDED when it releases the lock
+   calls FUTEX_WAKE; one that sees MUTEX_LOCKED knows nobody can be
+   sleeping and skips the system call. */
+
+/* Initializes M as a free lock. */
+void
+mutex_init (struct mutex *m) {
+	m->state = MUTEX_FREE;
+}
+
+/* Takes M, sleeping in the kernel for as long as another process
+   holds it. */
+void
+mutex_lock (struct mutex *m) {
+	int c = MUTEX_FREE;
+
+	if (__atomic_compare_exchange_n (&m->state, &c, MUTEX_LOCKED, false,
+				__ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return;
+
+	/* 잠들기 전에 기다리는 프로세스가 있다고 표시해 둬야 unlock이 깨워준다. */
+	if (c != MUTEX_CONTENDED)
+		c = __atomic_exchange_n (&m->state, MUTEX_CONTENDED, __ATOMIC_ACQUIRE);
+	while (c != MUTEX_FREE) {
+		futex (&m->state, FUTEX_WAIT, MUTEX_CONTENDED);
+		c = __atomic_exchange_n (&m->state, MUTEX_CONTENDED, __ATOMIC_ACQUIRE);
+	}
+}
+
+/* Takes M if it is free.  Returns true if successful, false if
+   another process holds it.  Never enters the kernel. */
+bool
+mutex_trylock (struct mutex *m) {
+	int c = MUTEX_FREE;
+
+	return __atomic_compare_exchange_n (&m->state, &c, MUTEX_LOCKED, false,
+			__ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+/* Releases M, which the caller must hold, and wakes one sleeper
+   if there may be any. */
+void
+mutex_unlock (struct mutex *m) {
+	if (__atomic_exchange_n (&m->state, MUTEX_FREE, __ATOMIC_RELEASE)
+			== MUTEX_CONTENDED)
+		futex (&m->state, FUTEX_WAKE, 1);
+}
@@ -145,6 +145,21 @@ dup2 (int oldfd, int newfd){
 	return syscall2 (SYS_DUP2, oldfd, newfd);
 }
 
+int
+futex (int *uaddr, int op, int val) {
+	return syscall3 (SYS_FUTEX, uaddr, op, val);
+}
+
+uint64_t
+clock_ns (void) {
+	return syscall0 (SYS_CLOCK_NS);
+}
+
+int
+sched_stats (pid_t pid, struct sched_stats *stats) {
+	return syscall2 (SYS_SCHED_STATS, pid, stats);
+}
+
 void *
 mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	return (void *) syscall5 (SYS_MMAP, addr, length, writable, fd, offset);
@@ -0,0 +1,42 @@
+#include <vdso.h>
+#include <vdso-data.h>
+
+#define TIME ((const struct vdso_time *) VDSO_ADDR)
+#define PROC ((const struct vdso_proc *) VDSO_PROC_ADDR)
+
+static inline uint64_t
+rdtsc (void) {
+	uint32_t lo, hi;
+	__asm __volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((uint64_t) hi << 32) | lo;
+}
+
+/* Returns the number of timer ticks since the OS booted. */
+int64_t
+vdso_ticks (void) {
+	return TIME->ticks;
+}
+
+/* Returns the number of nanoseconds since the OS booted, like
+   the clock_ns() system call. */
+uint64_t
+vdso_clock_ns (void) {
+	uint64_t mult = TIME->tsc_ns_mult;
+
+	if (mult == 0)
+		return TIME->ticks * (1000000000ULL / TIME->timer_freq);
+	return TIME->tsc_ns_base + (uint64_t)
+		(((unsigned __int128) (rdtsc () - TIME->tsc_base) * mult) >> 32);
+}
+
+/* Returns the process identifier of the calling process. */
+pid_t
+vdso_getpid (void) {
+	return PROC->pid;
+}
+
+/* Returns the CPU the calling process last started running on. */
+int
+vdso_cpu (void) {
+	return PROC->cpu;
+}
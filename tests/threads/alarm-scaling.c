@@ -0,0 +1,91 @@
+/* Measures how the timer interrupt handler scales with the
+   number of sleeping threads.
+
+   For 10, 100 and 1000 threads, each thread sleeps a random
+   number of ticks, several times over.  While they run, we track
+   the longest time any single timer interrupt took, which is
+   where sleepers are woken, and report it in TSC cycles.
+
+   A sleeper fails the test if it wakes before its ticks are up.  We
+   give all of them SLACK ticks per sleep beyond the longest they can
+   ask for, and fail if any sleeper has still not finished by then,
+   so a wakeup that the timer handler drops is caught instead of
+   hanging the test.  The cycle counts themselves are only printed. */
+
+#include <stdio.h>
+#include <random.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Number of times each thread sleeps. */
+#define ITER_CNT 5
+
+/* Each sleep lasts between 1 and MAX_SLEEP ticks. */
+#define MAX_SLEEP 300
+
+/* Ticks a sleep may run late before we count it as lost. */
+#define SLACK 20
+
+static struct semaphore done;
+
+static thread_func sleeper;
+static void measure (int thread_cnt);
+
+void
+test_alarm_scaling (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  measure (10);
+  measure (100);
+  measure (1000);
+}
+
+static void
+measure (int thread_cnt) 
+{
+  int64_t start;
+  int woken;
+  int i;
+
+  sema_init (&done, 0);
+  timer_reset_max_tick_cycles ();
+  start = timer_ticks ();
+  for (i = 0; i < thread_cnt; i++)
+    if (thread_create ("sleeper", PRI_DEFAULT, sleeper, NULL) == TID_ERROR)
+      fail ("out of memory creating thread %d", i);
+
+  /* Every sleeper must be done by the time we wake. */
+  timer_sleep (ITER_CNT * (MAX_SLEEP + SLACK));
+  for (woken = 0; woken < thread_cnt && sema_try_down (&done); woken++)
+    continue;
+  if (woken < thread_cnt)
+    fail ("%d of %d sleepers not done after %lld ticks",
+          thread_cnt - woken, thread_cnt, (long long) timer_elapsed (start));
+
+  msg ("%4d sleepers: worst-case tick handler %llu cycles over %lld ticks",
+       thread_cnt, (unsigned long long) timer_max_tick_cycles (),
+       (long long) timer_elapsed (start));
+}
+
+static void
+sleeper (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      int64_t ticks = 1 + random_ulong () % MAX_SLEEP;
+      int64_t start = timer_ticks ();
+
+      timer_sleep (ticks);
+      if (timer_elapsed (start) < ticks)
+        fail ("woke after %lld of %lld ticks",
+              (long long) timer_elapsed (start), (long long) ticks);
+    }
+  sema_up (&done);
+}
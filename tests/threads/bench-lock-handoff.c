@@ -0,0 +1,110 @@
+/* Ping-pongs a lock between two threads and counts the context
+   switches it takes per acquisition, once with direct handoff
+   and once with barging allowed.
+
+   Each of THREAD_CNT threads acquires the lock ITER_CNT times and
+   yields while holding it, so that the other thread runs and
+   blocks on the lock.  With direct handoff, lock_release() gives
+   the lock to the blocked thread, so ownership alternates on every
+   acquisition.  With barging, the releasing thread takes the lock
+   right back before the woken thread runs, which then only finds
+   the lock taken and goes back to sleep.
+
+   For each mode, reports the number of context switches per 100
+   acquisitions and how often the lock changed owner.
+
+   In both modes, a thread that finds another one inside the lock
+   fails the test.  With direct handoff, the other thread is always
+   waiting when the lock is released, so every acquisition must
+   change the owner; one that does not means lock_release() let the
+   releasing thread barge after all.  The switch counts themselves
+   are only printed. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define THREAD_CNT 2
+#define ITER_CNT 500
+
+static struct lock lock;
+static struct semaphore done;
+static int last_owner;
+static int owner_changes;
+static int holders;
+
+static thread_func pingpong_func;
+static void measure (bool barging);
+
+void
+test_bench_lock_handoff (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  measure (false);
+  measure (true);
+}
+
+static void
+measure (bool barging) 
+{
+  long long switches;
+  int i;
+
+  lock_init (&lock);
+  if (barging)
+    lock_allow_barging (&lock);
+  sema_init (&done, 0);
+  last_owner = -1;
+  owner_changes = holders = 0;
+
+  /* Hold the lock until both threads are waiting for it, so that
+     they start out contending. */
+  lock_acquire (&lock);
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "pingpong %d", i);
+      if (thread_create (name, PRI_DEFAULT + 1, pingpong_func,
+                         (void *) (intptr_t) i) == TID_ERROR)
+        fail ("out of memory creating thread %d", i);
+    }
+  switches = thread_switch_cnt ();
+  lock_release (&lock);
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  switches = thread_switch_cnt () - switches;
+
+  if (!barging && owner_changes != THREAD_CNT * ITER_CNT)
+    fail ("lock changed owner on only %d of %d handoffs",
+          owner_changes, THREAD_CNT * ITER_CNT);
+
+  msg ("%-8s %d acquisitions: %lld switches per 100 acquisitions, "
+       "%d owner changes",
+       barging ? "barging" : "handoff", THREAD_CNT * ITER_CNT,
+       switches * 100 / (THREAD_CNT * ITER_CNT), owner_changes);
+}
+
+static void
+pingpong_func (void *id_) 
+{
+  int id = (intptr_t) id_;
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++) 
+    {
+      lock_acquire (&lock);
+      if (holders++ != 0)
+        fail ("pingpong %d acquired the lock while it was held", id);
+      if (last_owner != id)
+        owner_changes++;
+      last_owner = id;
+      thread_yield ();
+      holders--;
+      lock_release (&lock);
+    }
+  sema_up (&done);
+}
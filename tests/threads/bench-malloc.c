@@ -0,0 +1,165 @@
+/* Measures malloc() and free() on two allocation-heavy patterns.
+
+   In the churn pattern, SLOT_CNT slots each hold at most one
+   block.  Each of OP_CNT steps picks a random slot and frees what
+   it holds, or allocates a block of 1 to MAX_SIZE bytes into it if
+   it is empty, with small sizes much more likely than large ones.
+   Blocks are filled after allocation, as real callers would.
+
+   In the burst pattern, each of BURST_CNT rounds allocates
+   BURST_SIZE blocks of BURST_BYTES bytes and then frees them all.
+   The number of blocks in use goes up and down across whole
+   arenas, which is where keeping a few empty arenas instead of
+   returning them to palloc at once pays off.
+
+   Costs are reported in TSC cycles per operation.  free() also
+   fills the freed block with 0xcc in debug builds, so free costs
+   include that.  Run with -kmemstat to see how many arenas each
+   size class took from palloc and how often the per-CPU
+   magazines served a request.
+
+   Each block is filled with a byte that differs from the blocks
+   allocated just before and after it, and is checked just before
+   it is freed, outside the timed region.  A block that malloc()
+   also handed to someone else, or that a free() scribbled on while
+   it was still in use, fails the test.  The timings themselves are
+   only printed. */
+
+#include <stdio.h>
+#include <random.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "intrinsic.h"
+
+#define SLOT_CNT 512
+#define OP_CNT 20000
+#define MAX_SIZE 2048
+#define BURST_CNT 200
+#define BURST_SIZE 256
+#define BURST_BYTES 48
+
+static void *slots[SLOT_CNT];
+static size_t sizes[SLOT_CNT];
+static uint8_t tags[SLOT_CNT];
+
+static void fill_block (int slot, void *, size_t, uint8_t tag);
+static void check_block (const char *pattern, int slot);
+static void measure_churn (void);
+static void measure_burst (void);
+
+void
+test_bench_malloc (void)
+{
+  measure_churn ();
+  measure_burst ();
+}
+
+static void
+measure_churn (void)
+{
+  uint64_t alloc_cycles = 0, free_cycles = 0, start;
+  int alloc_cnt = 0, free_cnt = 0;
+  int i;
+
+  random_init (0);
+  for (i = 0; i < OP_CNT; i++)
+    {
+      int slot = random_ulong () % SLOT_CNT;
+      void **s = &slots[slot];
+
+      if (*s != NULL)
+        {
+          check_block ("churn", slot);
+          start = rdtsc ();
+          free (*s);
+          free_cycles += rdtsc () - start;
+          free_cnt++;
+          *s = NULL;
+        }
+      else
+        {
+          /* Dividing twice makes small sizes the common case. */
+          size_t size = 1 + random_ulong () % MAX_SIZE;
+          size = 1 + random_ulong () % size;
+
+          start = rdtsc ();
+          *s = malloc (size);
+          alloc_cycles += rdtsc () - start;
+          alloc_cnt++;
+          if (*s == NULL)
+            fail ("churn: out of memory allocating %zu bytes", size);
+          fill_block (slot, *s, size, i);
+        }
+    }
+
+  for (i = 0; i < SLOT_CNT; i++)
+    {
+      if (slots[i] != NULL)
+        check_block ("churn", i);
+      free (slots[i]);
+      slots[i] = NULL;
+    }
+
+  msg ("churn: alloc %llu cycles/op, free %llu cycles/op",
+       (unsigned long long) (alloc_cycles / alloc_cnt),
+       (unsigned long long) (free_cycles / free_cnt));
+}
+
+static void
+measure_burst (void)
+{
+  uint64_t alloc_cycles = 0, free_cycles = 0, start;
+  int round, i;
+
+  for (round = 0; round < BURST_CNT; round++)
+    {
+      start = rdtsc ();
+      for (i = 0; i < BURST_SIZE; i++)
+        {
+          slots[i] = malloc (BURST_BYTES);
+          if (slots[i] == NULL)
+            fail ("burst: out of memory");
+        }
+      alloc_cycles += rdtsc () - start;
+
+      for (i = 0; i < BURST_SIZE; i++)
+        fill_block (i, slots[i], BURST_BYTES, round + i);
+      for (i = 0; i < BURST_SIZE; i++)
+        check_block ("burst", i);
+
+      start = rdtsc ();
+      for (i = 0; i < BURST_SIZE; i++)
+        free (slots[i]);
+      free_cycles += rdtsc () - start;
+    }
+  memset (slots, 0, sizeof slots);
+
+  msg ("burst: alloc %llu cycles/op, free %llu cycles/op",
+       (unsigned long long) (alloc_cycles / (BURST_CNT * BURST_SIZE)),
+       (unsigned long long) (free_cycles / (BURST_CNT * BURST_SIZE)));
+}
+
+/* Records BLOCK of SIZE bytes in SLOT and fills it with TAG. */
+static void
+fill_block (int slot, void *block, size_t size, uint8_t tag)
+{
+  slots[slot] = block;
+  sizes[slot] = size;
+  tags[slot] = tag;
+  memset (block, tag, size);
+}
+
+/* Fails if the block in SLOT no longer holds only its tag. */
+static void
+check_block (const char *pattern, int slot)
+{
+  const uint8_t *p = slots[slot];
+  size_t i;
+
+  for (i = 0; i < sizes[slot]; i++)
+    if (p[i] != tags[slot])
+      fail ("%s: byte %zu of %zu-byte block %p is 0x%02x, not 0x%02x",
+            pattern, i, sizes[slot], slots[slot], p[i], tags[slot]);
+}
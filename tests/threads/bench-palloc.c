@@ -0,0 +1,201 @@
+/* Compares the buddy page allocator with the bitmap scan it
+   replaced, on a fragmented pool.
+
+   Each allocator is fragmented the same way before anything is
+   timed: FRAG_PAGES single pages are allocated and every other one
+   is freed again, leaving FRAG_PAGES / 2 one-page holes.  For the
+   bitmap, the holes are at the bottom, where
+   bitmap_scan_and_flip() starts looking.
+
+   Then SLOT_CNT slots each hold at most one allocation.  Each of
+   OP_CNT steps picks a random slot and frees what it holds, or
+   allocates 2 to MAX_PAGES pages into it if it is empty.  The
+   sequence is run once through palloc_get_multiple() on the
+   kernel pool, which takes such runs straight from the buddy free
+   lists of their order, and once through bitmap_scan_and_flip() on
+   a bitmap of BITMAP_PAGES pages, the size of the kernel pool with
+   the default 256 MB of memory, which is what palloc used to do and
+   which has to step over every hole first.  Allocation costs are
+   reported in TSC cycles per operation.
+
+   Every run handed out must not overlap a run that is still held.
+   After everything is freed again, the largest run that can be
+   allocated must be as large as before fragmenting, so pages that
+   the buddy allocator failed to merge back make the test fail.
+   The timings themselves are only printed. */
+
+#include <stdio.h>
+#include <bitmap.h>
+#include <random.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+#define SLOT_CNT 256
+#define OP_CNT 4000
+#define MAX_PAGES 16
+#define FRAG_PAGES 4096
+#define BITMAP_PAGES 32768
+#define MAX_PROBE 4096
+
+/* One allocation: its first page number and its size. */
+struct slot
+  {
+    size_t page;
+    size_t page_cnt;
+  };
+
+static struct slot slots[SLOT_CNT];
+static size_t frag[FRAG_PAGES];
+static struct bitmap *map;
+
+static size_t buddy_alloc (size_t page_cnt);
+static void buddy_free (size_t page, size_t page_cnt);
+static size_t bitmap_alloc (size_t page_cnt);
+static void bitmap_free (size_t page, size_t page_cnt);
+static size_t largest_run (size_t (*alloc_fn) (size_t),
+                           void (*free_fn) (size_t, size_t));
+static void check_overlap (const char *name, const struct slot *);
+static void measure (const char *name, size_t (*alloc_fn) (size_t),
+                     void (*free_fn) (size_t, size_t));
+
+void
+test_bench_palloc (void)
+{
+  map = bitmap_create (BITMAP_PAGES);
+  if (map == NULL)
+    fail ("out of memory creating bitmap");
+
+  measure ("bitmap", bitmap_alloc, bitmap_free);
+  measure ("palloc", buddy_alloc, buddy_free);
+  bitmap_destroy (map);
+}
+
+static void
+measure (const char *name, size_t (*alloc_fn) (size_t),
+         void (*free_fn) (size_t, size_t))
+{
+  uint64_t alloc_cycles = 0, start;
+  int alloc_cnt = 0;
+  size_t before, after, page;
+  int i;
+
+  before = largest_run (alloc_fn, free_fn);
+
+  /* Fragment: allocate single pages, then free every other one. */
+  for (i = 0; i < FRAG_PAGES; i++)
+    {
+      frag[i] = alloc_fn (1);
+      if (frag[i] == BITMAP_ERROR)
+        fail ("%s: out of memory fragmenting", name);
+    }
+  for (i = 1; i < FRAG_PAGES; i += 2)
+    free_fn (frag[i], 1);
+
+  random_init (0);
+  for (i = 0; i < OP_CNT; i++)
+    {
+      struct slot *s = &slots[random_ulong () % SLOT_CNT];
+
+      if (s->page_cnt > 0)
+        {
+          free_fn (s->page, s->page_cnt);
+          s->page_cnt = 0;
+        }
+      else
+        {
+          size_t page_cnt = 2 + random_ulong () % (MAX_PAGES - 1);
+
+          start = rdtsc ();
+          page = alloc_fn (page_cnt);
+          alloc_cycles += rdtsc () - start;
+          alloc_cnt++;
+          if (page == BITMAP_ERROR)
+            fail ("%s: out of memory allocating %zu pages", name, page_cnt);
+          s->page = page;
+          s->page_cnt = page_cnt;
+          check_overlap (name, s);
+        }
+    }
+
+  /* Give everything back. */
+  for (i = 0; i < SLOT_CNT; i++)
+    if (slots[i].page_cnt > 0)
+      {
+        free_fn (slots[i].page, slots[i].page_cnt);
+        slots[i].page_cnt = 0;
+      }
+  for (i = 0; i < FRAG_PAGES; i += 2)
+    free_fn (frag[i], 1);
+
+  after = largest_run (alloc_fn, free_fn);
+  if (after < before)
+    fail ("%s: largest free run shrank from %zu to %zu pages",
+          name, before, after);
+
+  msg ("%s: alloc %llu cycles/op with %d holes", name,
+       (unsigned long long) (alloc_cycles / alloc_cnt), FRAG_PAGES / 2);
+}
+
+/* Returns the largest power-of-two run of pages, up to MAX_PROBE,
+   that ALLOC_FN can allocate at the moment. */
+static size_t
+largest_run (size_t (*alloc_fn) (size_t), void (*free_fn) (size_t, size_t))
+{
+  size_t largest, page;
+
+  for (largest = MAX_PROBE; largest > 0; largest /= 2)
+    {
+      page = alloc_fn (largest);
+      if (page != BITMAP_ERROR)
+        {
+          free_fn (page, largest);
+          break;
+        }
+    }
+  return largest;
+}
+
+/* Fails if slot S overlaps another slot that holds pages. */
+static void
+check_overlap (const char *name, const struct slot *s)
+{
+  int i;
+
+  for (i = 0; i < SLOT_CNT; i++)
+    {
+      const struct slot *t = &slots[i];
+
+      if (t != s && t->page_cnt > 0
+          && t->page < s->page + s->page_cnt
+          && s->page < t->page + t->page_cnt)
+        fail ("%s: pages %zu+%zu handed out twice", name, s->page, s->page_cnt);
+    }
+}
+
+static size_t
+buddy_alloc (size_t page_cnt)
+{
+  void *pages = palloc_get_multiple (0, page_cnt);
+  return pages != NULL ? pg_no (pages) : BITMAP_ERROR;
+}
+
+static void
+buddy_free (size_t page, size_t page_cnt)
+{
+  palloc_free_multiple ((void *) (page << PGBITS), page_cnt);
+}
+
+static size_t
+bitmap_alloc (size_t page_cnt)
+{
+  return bitmap_scan_and_flip (map, 0, page_cnt, false);
+}
+
+static void
+bitmap_free (size_t page, size_t page_cnt)
+{
+  bitmap_set_multiple (map, page, page_cnt, false);
+}
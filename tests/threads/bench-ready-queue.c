@@ -0,0 +1,110 @@
+/* Measures the cost of run queue operations with 10, 100 and
+   1000 threads ready to run.
+
+   For each size, that many threads with random priorities below
+   ours block themselves.  We then time thread_unblock() on all of
+   them (enqueue), and then time how long it takes for all of them
+   to be scheduled and report back (dequeue plus context switch).
+   Costs are reported in TSC cycles per thread.
+
+   Since we wait at a higher priority than any of them, each thread
+   only runs once we block again, so they must be dequeued highest
+   priority first: the test fails if a thread runs after one of
+   lower priority, or if any thread put on the run queue never
+   runs.  The timings themselves are only printed. */
+
+#include <stdio.h>
+#include <random.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define MAX_THREAD_CNT 1000
+
+static struct thread *blocked[MAX_THREAD_CNT];
+static int blocked_cnt;
+static int woken[MAX_THREAD_CNT];
+static int woken_cnt;
+static struct semaphore done;
+
+static thread_func blocker_func;
+static void measure (int thread_cnt);
+
+void
+test_bench_ready_queue (void) 
+{
+  /* This benchmark does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  measure (10);
+  measure (100);
+  measure (1000);
+}
+
+static void
+measure (int thread_cnt) 
+{
+  uint64_t start, enqueue, dequeue;
+  enum intr_level old_level;
+  int i;
+
+  ASSERT (thread_cnt <= MAX_THREAD_CNT);
+
+  blocked_cnt = woken_cnt = 0;
+  sema_init (&done, 0);
+  for (i = 0; i < thread_cnt; i++) 
+    {
+      int priority = PRI_MIN + 1 + random_ulong () % (PRI_DEFAULT - PRI_MIN - 1);
+      if (thread_create ("blocker", priority, blocker_func, NULL) == TID_ERROR)
+        fail ("out of memory creating thread %d", i);
+    }
+
+  /* Let every new thread run far enough to block itself. */
+  thread_set_priority (PRI_MIN);
+  thread_set_priority (PRI_DEFAULT);
+  ASSERT (blocked_cnt == thread_cnt);
+
+  /* None of them outranks us, so this only fills the run queue. */
+  start = rdtsc ();
+  old_level = intr_disable ();
+  for (i = 0; i < thread_cnt; i++)
+    thread_unblock (blocked[i]);
+  intr_set_level (old_level);
+  enqueue = rdtsc () - start;
+
+  /* Now let them all drain out of the run queue. */
+  start = rdtsc ();
+  for (i = 0; i < thread_cnt; i++)
+    sema_down (&done);
+  dequeue = rdtsc () - start;
+
+  /* Check that the run queue handed them out by priority. */
+  if (woken_cnt != thread_cnt)
+    fail ("%d of %d threads ran", woken_cnt, thread_cnt);
+  for (i = 1; i < thread_cnt; i++)
+    if (woken[i] > woken[i - 1])
+      fail ("priority %d thread ran after priority %d thread",
+            woken[i], woken[i - 1]);
+
+  msg ("%4d ready threads: enqueue %llu cycles/op, dequeue+switch %llu cycles/op",
+       thread_cnt, (unsigned long long) (enqueue / thread_cnt),
+       (unsigned long long) (dequeue / thread_cnt));
+}
+
+static void 
+blocker_func (void *aux UNUSED) 
+{
+  intr_disable ();
+  blocked[blocked_cnt++] = thread_current ();
+  thread_block ();
+  woken[woken_cnt++] = thread_get_priority ();
+  intr_enable ();
+
+  sema_up (&done);
+}
@@ -0,0 +1,153 @@
+/* Compares struct rwlock with struct lock on a read-mostly
+   workload, and checks the reader-writer invariants while doing
+   so.
+
+   THREAD_CNT threads each perform OP_CNT operations on a shared
+   resource: 90% reads and 10% writes, chosen at random.  Each
+   operation sleeps for a tick inside the critical section to
+   stand in for disk I/O, so readers holding an rwlock overlap
+   their waits while readers holding a plain lock do not.  The run
+   is repeated once with a struct lock and once with a struct
+   rwlock, and the elapsed ticks are reported.
+
+   Any reader seen together with a writer, or two writers seen
+   together, fails the test.  So does a write that the resource
+   does not show afterward, and, with the rwlock, a run in which no
+   two readers ever held the lock at once, since then it bought
+   nothing over a plain lock.  The tick counts themselves are only
+   printed. */
+
+#include <stdio.h>
+#include <random.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 8
+#define OP_CNT 20
+#define WRITE_PCT 10
+
+static struct lock lock;
+static struct rwlock rwlock;
+static bool use_rwlock;
+
+static int active_readers;
+static int active_writers;
+static int max_readers;
+static int version;
+static int write_cnt;
+static struct semaphore done;
+
+static thread_func worker_func;
+static void measure (bool rw);
+static void add_reader (int);
+
+void
+test_bench_rwlock (void) 
+{
+  lock_init (&lock);
+  rwlock_init (&rwlock);
+  random_init (0);
+
+  measure (false);
+  measure (true);
+}
+
+static void
+measure (bool rw) 
+{
+  int64_t start;
+  int i;
+
+  use_rwlock = rw;
+  max_readers = version = write_cnt = 0;
+  sema_init (&done, 0);
+
+  start = timer_ticks ();
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "worker %d", i);
+      if (thread_create (name, PRI_DEFAULT, worker_func, NULL) == TID_ERROR)
+        fail ("out of memory creating thread %d", i);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+
+  if (version != write_cnt)
+    fail ("%d writes made, but resource is at version %d",
+          write_cnt, version);
+  if (rw && max_readers < 2)
+    fail ("readers never shared the rwlock");
+
+  msg ("%-13s %d threads x %d ops, %d%% writes: %lld ticks",
+       rw ? "struct rwlock" : "struct lock", THREAD_CNT, OP_CNT, WRITE_PCT,
+       timer_elapsed (start));
+}
+
+static void
+worker_func (void *aux UNUSED) 
+{
+  enum intr_level old_level;
+  int writes = 0;
+  int i;
+
+  for (i = 0; i < OP_CNT; i++) 
+    {
+      bool write = random_ulong () % 100 < WRITE_PCT;
+
+      if (!use_rwlock)
+        lock_acquire (&lock);
+      else if (write)
+        rwlock_acquire_write (&rwlock);
+      else
+        rwlock_acquire_read (&rwlock);
+
+      if (write) 
+        {
+          if (active_readers != 0 || active_writers != 0)
+            fail ("writer entered with %d readers, %d writers",
+                  active_readers, active_writers);
+          active_writers++;
+          timer_sleep (1);
+          version++;
+          writes++;
+          active_writers--;
+        }
+      else 
+        {
+          if (active_writers != 0)
+            fail ("reader entered with %d writers", active_writers);
+          add_reader (1);
+          timer_sleep (1);
+          add_reader (-1);
+        }
+
+      if (!use_rwlock)
+        lock_release (&lock);
+      else if (write)
+        rwlock_release_write (&rwlock);
+      else
+        rwlock_release_read (&rwlock);
+    }
+
+  old_level = intr_disable ();
+  write_cnt += writes;
+  intr_set_level (old_level);
+  sema_up (&done);
+}
+
+/* Adds DELTA to the number of active readers.  Readers holding the
+   rwlock run this together, so it must not be preempted. */
+static void
+add_reader (int delta) 
+{
+  enum intr_level old_level = intr_disable ();
+  active_readers += delta;
+  if (active_readers > max_readers)
+    max_readers = active_readers;
+  intr_set_level (old_level);
+}
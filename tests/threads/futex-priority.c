@@ -0,0 +1,50 @@
+/* Checks that FUTEX_WAKE wakes the highest-priority sleeper first
+   and reports how many threads it woke.
+
+   User processes all run at PRI_DEFAULT, so this is a kernel test
+   that calls futex_wait() and futex_wake() on a kernel word
+   directly, the way the system call does after translating the
+   user address. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "userprog/futex.h"
+
+static thread_func futex_priority_thread;
+static int word;
+
+void
+test_futex_priority (void) 
+{
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  thread_set_priority (PRI_MIN);
+  for (i = 0; i < 10; i++) 
+    {
+      int priority = PRI_DEFAULT - (i + 3) % 10 - 1;
+      char name[16];
+      snprintf (name, sizeof name, "priority %d", priority);
+      thread_create (name, priority, futex_priority_thread, NULL);
+    }
+
+  for (i = 0; i < 5; i++) 
+    {
+      msg ("Woke %d.", futex_wake (&word, 1));
+      msg ("Back in main thread.");
+    }
+  msg ("Woke %d.", futex_wake (&word, 10));
+  msg ("Woke %d.", futex_wake (&word, 10));
+}
+
+static void
+futex_priority_thread (void *aux UNUSED) 
+{
+  if (futex_wait (&word, 0) != 0)
+    fail ("futex_wait returned without sleeping");
+  msg ("Thread %s woke up.", thread_name ());
+}
@@ -0,0 +1,122 @@
+/* Checks that struct intq keeps bytes in order through its full
+   and empty states and across the end of its buffer.
+
+   On an 8-byte queue, we first fill it one byte at a time and
+   check that it reports full and refuses a ninth byte, then drain
+   it and check that it reports empty and has nothing left to give.
+   Then we move bytes through it in batches of every size from 1 to
+   QUEUE_SIZE + 1, so that batches start and end at every offset
+   in the buffer and HEAD and TAIL wrap it many times over.
+
+   Last, a producer thread pushes THREAD_BYTES bytes with
+   intq_putc() while we take them with intq_getc(), so that each
+   side has to sleep on the other whenever the queue runs full or
+   empty. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/intq.h"
+
+#define QUEUE_SIZE 8
+#define THREAD_BYTES 1000
+
+static struct intq q;
+static uint8_t q_buf[QUEUE_SIZE];
+static struct semaphore done;
+
+static thread_func producer;
+static void check_state (const char *when, bool empty, bool full);
+
+void
+test_intq_ring (void)
+{
+  uint8_t buf[QUEUE_SIZE + 1];
+  uint8_t next_put = 0, next_get = 0;
+  size_t cnt, i;
+  int round;
+
+  intq_init (&q, q_buf, sizeof q_buf);
+  check_state ("after init", true, false);
+  if (intq_get_many (&q, buf, 1) != 0)
+    fail ("got a byte from an empty queue");
+
+  /* Fill. */
+  for (i = 0; i < QUEUE_SIZE; i++)
+    {
+      check_state ("while filling", i == 0, false);
+      if (intq_put_many (&q, &next_put, 1) != 1)
+        fail ("queue refused byte %zu of %d", i + 1, QUEUE_SIZE);
+      next_put++;
+    }
+  check_state ("when filled", false, true);
+  if (intq_put_many (&q, &next_put, 1) != 0)
+    fail ("full queue took another byte");
+  msg ("filled queue with %d bytes", QUEUE_SIZE);
+
+  /* Drain. */
+  cnt = intq_get_many (&q, buf, sizeof buf);
+  if (cnt != QUEUE_SIZE)
+    fail ("drained %zu bytes from a full queue", cnt);
+  for (i = 0; i < cnt; i++)
+    if (buf[i] != next_get++)
+      fail ("drained byte %zu is %d", i, buf[i]);
+  check_state ("when drained", true, false);
+  msg ("drained queue");
+
+  /* Wrap, in batches of every size. */
+  for (round = 0; round < 64; round++)
+    {
+      size_t batch = round % (QUEUE_SIZE + 1) + 1;
+
+      for (i = 0; i < batch; i++)
+        buf[i] = next_put + i;
+      cnt = intq_put_many (&q, buf, batch);
+      if (cnt != (batch < QUEUE_SIZE ? batch : QUEUE_SIZE))
+        fail ("put %zu of %zu bytes into an empty queue", cnt, batch);
+      next_put += cnt;
+      check_state ("after a batch", false, cnt == QUEUE_SIZE);
+
+      cnt = intq_get_many (&q, buf, sizeof buf);
+      for (i = 0; i < cnt; i++)
+        if (buf[i] != next_get++)
+          fail ("round %d: byte %zu is %d", round, i, buf[i]);
+      check_state ("after a batch", true, false);
+    }
+  msg ("wrapped queue %d times", (int) (q.head / QUEUE_SIZE));
+
+  /* Hand bytes over between two threads. */
+  sema_init (&done, 0);
+  thread_create ("producer", PRI_DEFAULT, producer, NULL);
+  for (i = 0; i < THREAD_BYTES; i++)
+    {
+      uint8_t byte = intq_getc (&q);
+      if (byte != (uint8_t) i)
+        fail ("byte %zu from producer is %d", i, byte);
+    }
+  sema_down (&done);
+  check_state ("after producer", true, false);
+  msg ("received %d bytes from producer", THREAD_BYTES);
+}
+
+static void
+producer (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < THREAD_BYTES; i++)
+    intq_putc (&q, i);
+  sema_up (&done);
+}
+
+/* Fails if the queue is not EMPTY and FULL as given. */
+static void
+check_state (const char *when, bool empty, bool full)
+{
+  if (intq_empty (&q) != empty)
+    fail ("queue %s empty %s", empty ? "not" : "is", when);
+  if (intq_full (&q) != full)
+    fail ("queue %s full %s", full ? "not" : "is", when);
+}
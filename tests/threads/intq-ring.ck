@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(intq-ring) begin
+(intq-ring) filled queue with 8 bytes
+(intq-ring) drained queue
+(intq-ring) wrapped queue 39 times
+(intq-ring) received 1000 bytes from producer
+(intq-ring) end
+EOF
+pass;
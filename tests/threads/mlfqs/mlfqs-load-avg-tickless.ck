@@ -0,0 +1,6 @@
+# -*- perl -*-
+# mlfqs-load-avg, run with -tickless.
+use strict;
+use warnings;
+do "tests/threads/mlfqs/mlfqs-load-avg.ck";
+die $@ || "tests/threads/mlfqs/mlfqs-load-avg.ck: $!\n";
@@ -0,0 +1,6 @@
+# -*- perl -*-
+# mlfqs-recent-1, run with -tickless.
+use strict;
+use warnings;
+do "tests/threads/mlfqs/mlfqs-recent-1.ck";
+die $@ || "tests/threads/mlfqs/mlfqs-recent-1.ck: $!\n";
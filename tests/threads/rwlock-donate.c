@@ -0,0 +1,81 @@
+/* The main thread acquires an rwlock for reading.  Then it
+   creates a higher-priority writer and an even higher-priority
+   reader.  The writer blocks because the lock is held, and the
+   reader blocks because a writer is waiting, and both donate
+   their priorities to the main thread.  When the main thread
+   releases the lock, the writer must go first, and it must
+   receive the waiting reader's priority while it holds the lock.
+
+   Finally, the main thread checks the try, upgrade and downgrade
+   operations on an uncontended lock. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func writer_thread_func;
+static thread_func reader_thread_func;
+
+void
+test_rwlock_donate (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  rwlock_acquire_read (&rw);
+  thread_create ("writer", PRI_DEFAULT + 1, writer_thread_func, &rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+  thread_create ("reader", PRI_DEFAULT + 2, reader_thread_func, &rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 2, thread_get_priority ());
+  rwlock_release_read (&rw);
+  msg ("writer, reader must already have finished, in that order.");
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+
+  rwlock_acquire_read (&rw);
+  msg ("try_acquire_write while reading: %s",
+       rwlock_try_acquire_write (&rw) ? "acquired" : "failed");
+  msg ("try_upgrade as the only reader: %s",
+       rwlock_try_upgrade (&rw) ? "upgraded" : "failed");
+  msg ("held for writing: %s", rwlock_held_by_current_thread (&rw) ? "yes" : "no");
+  rwlock_downgrade (&rw);
+  msg ("held for writing after downgrade: %s",
+       rwlock_held_by_current_thread (&rw) ? "yes" : "no");
+  msg ("upgrade: %s", rwlock_upgrade (&rw) ? "atomic" : "not atomic");
+  rwlock_release_write (&rw);
+  msg ("try_acquire_read when free: %s",
+       rwlock_try_acquire_read (&rw) ? "acquired" : "failed");
+  rwlock_release_read (&rw);
+}
+
+static void
+writer_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_acquire_write (rw);
+  msg ("writer: got the lock, priority %d", thread_get_priority ());
+  rwlock_release_write (rw);
+  msg ("writer: done");
+}
+
+static void
+reader_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_acquire_read (rw);
+  msg ("reader: got the lock");
+  rwlock_release_read (rw);
+  msg ("reader: done");
+}
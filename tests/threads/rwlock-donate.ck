@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-donate) begin
+(rwlock-donate) This thread should have priority 32.  Actual priority: 32.
+(rwlock-donate) This thread should have priority 33.  Actual priority: 33.
+(rwlock-donate) writer: got the lock, priority 33
+(rwlock-donate) reader: got the lock
+(rwlock-donate) reader: done
+(rwlock-donate) writer: done
+(rwlock-donate) writer, reader must already have finished, in that order.
+(rwlock-donate) This thread should have priority 31.  Actual priority: 31.
+(rwlock-donate) try_acquire_write while reading: failed
+(rwlock-donate) try_upgrade as the only reader: upgraded
+(rwlock-donate) held for writing: yes
+(rwlock-donate) held for writing after downgrade: no
+(rwlock-donate) upgrade: atomic
+(rwlock-donate) try_acquire_read when free: acquired
+(rwlock-donate) end
+EOF
+pass;
@@ -0,0 +1,110 @@
+/* Checks that an idle CPU steals work from the run queue of a
+   busy sibling.  Run with `pintos --smp 2'.
+
+   The main thread creates THREAD_CNT threads at a lower priority
+   than its own.  New threads go on the run queue of the CPU that
+   creates them, and the main thread then keeps that CPU busy,
+   spinning without blocking until every thread has run, so the
+   threads can only run if another CPU takes them.  Each thread
+   records the CPU it ran on.  None may have run on the main
+   thread's CPU, and the thieves must have counted a steal and a
+   migration for every thread they took. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 8
+
+/* Give up waiting after this many seconds. */
+#define WAIT_SECS 10
+
+static int ran_on[THREAD_CNT];
+static int ran_cnt;
+
+static thread_func steal_thread;
+static void sum_counters (long long *steals, long long *migrations);
+
+void
+test_steal_work (void)
+{
+  long long steals, migrations, steals_after, migrations_after;
+  struct cpu *home;
+  int64_t start;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  if (cpu_online_cnt () < 2)
+    fail ("only %d CPU online, run with `pintos --smp 2'", cpu_online_cnt ());
+  msg ("At least 2 CPUs are online.");
+
+  sum_counters (&steals, &migrations);
+  home = this_cpu ();
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+
+      ran_on[i] = -1;
+      snprintf (name, sizeof name, "steal %d", i);
+      thread_create (name, PRI_DEFAULT - 1, steal_thread, &ran_on[i]);
+    }
+
+  /* Keep this CPU busy until the others have run every thread. */
+  start = timer_ticks ();
+  while (__atomic_load_n (&ran_cnt, __ATOMIC_ACQUIRE) < THREAD_CNT)
+    {
+      if (timer_elapsed (start) > WAIT_SECS * TIMER_FREQ)
+        fail ("only %d of %d threads ran within %d seconds",
+              __atomic_load_n (&ran_cnt, __ATOMIC_ACQUIRE), THREAD_CNT,
+              WAIT_SECS);
+      asm volatile ("pause" : : : "memory");
+    }
+  if (this_cpu () != home)
+    fail ("main thread moved from CPU %d to CPU %d",
+          home->id, this_cpu ()->id);
+  msg ("All %d threads ran.", THREAD_CNT);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    if (ran_on[i] == home->id)
+      fail ("thread %d ran on the main thread's CPU %d", i, home->id);
+  msg ("None ran on the main thread's CPU.");
+
+  sum_counters (&steals_after, &migrations_after);
+  if (steals_after - steals < 1)
+    fail ("no steals counted");
+  if (migrations_after - migrations < THREAD_CNT)
+    fail ("%lld migrations counted for %d stolen threads",
+          migrations_after - migrations, THREAD_CNT);
+  msg ("Steals and migrations were counted.");
+}
+
+static void
+steal_thread (void *ran_on_)
+{
+  int *ran_on_cpu = ran_on_;
+
+  *ran_on_cpu = this_cpu ()->id;
+  __atomic_fetch_add (&ran_cnt, 1, __ATOMIC_RELEASE);
+}
+
+/* Adds up the steal and migration counters of every CPU. */
+static void
+sum_counters (long long *steals, long long *migrations)
+{
+  enum intr_level old_level = intr_disable ();
+  int i;
+
+  *steals = *migrations = 0;
+  for (i = 0; i < cpu_cnt; i++)
+    {
+      *steals += cpus[i].steals;
+      *migrations += cpus[i].migrations;
+    }
+  intr_set_level (old_level);
+}
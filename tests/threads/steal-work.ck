@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(steal-work) begin
+(steal-work) At least 2 CPUs are online.
+(steal-work) All 8 threads ran.
+(steal-work) None ran on the main thread's CPU.
+(steal-work) Steals and migrations were counted.
+(steal-work) end
+EOF
+pass;
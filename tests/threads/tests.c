@@ -29,6 +29,13 @@ static const struct test tests[] =
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"rwlock-donate", test_rwlock_donate},
+    {"steal-work", test_steal_work},
+    {"intq-ring", test_intq_ring},
+    {"tickless-idle", test_tickless_idle},
+#ifdef USERPROG
+    {"futex-priority", test_futex_priority},
+#endif
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
@@ -38,6 +45,14 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"mlfqs-load-avg-tickless", test_mlfqs_load_avg},
+    {"mlfqs-recent-1-tickless", test_mlfqs_recent_1},
+    {"bench-ready-queue", test_bench_ready_queue},
+    {"alarm-scaling", test_alarm_scaling},
+    {"bench-rwlock", test_bench_rwlock},
+    {"bench-lock-handoff", test_bench_lock_handoff},
+    {"bench-palloc", test_bench_palloc},
+    {"bench-malloc", test_bench_malloc},
   };
 
 static const char *test_name;
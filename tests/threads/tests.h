@@ -23,6 +23,11 @@ extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_condvar;
+extern test_func test_rwlock_donate;
+extern test_func test_steal_work;
+extern test_func test_intq_ring;
+extern test_func test_tickless_idle;
+extern test_func test_futex_priority;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
@@ -32,6 +37,12 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_bench_ready_queue;
+extern test_func test_alarm_scaling;
+extern test_func test_bench_rwlock;
+extern test_func test_bench_lock_handoff;
+extern test_func test_bench_palloc;
+extern test_func test_bench_malloc;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
@@ -0,0 +1,48 @@
+/* Checks that an idle CPU stops taking timer interrupts when the
+   kernel runs with -tickless.
+
+   After a second to let the boot-time background work finish, the
+   main thread sleeps for SLEEP_TICKS ticks with nothing else to
+   run.  The periodic timer would interrupt once per tick over
+   that time; the one-shot timer armed on idle entry should need
+   only a few interrupts to get through it.  We fail if more than
+   MAX_INTERRUPTS timer interrupts were taken, or if the sleep came
+   back early because the ticks that went by while idle were not
+   all counted. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "devices/timer.h"
+
+/* Length of the idle sleep, in ticks. */
+#define SLEEP_TICKS 500
+
+/* Timer interrupts the sleep may take at most. */
+#define MAX_INTERRUPTS 10
+
+void
+test_tickless_idle (void)
+{
+  int64_t start, intr_start, slept, intr_cnt;
+
+  if (!timer_tickless)
+    fail ("this test must be run with -tickless");
+
+  timer_sleep (TIMER_FREQ);
+
+  start = timer_ticks ();
+  intr_start = timer_interrupts ();
+  timer_sleep (SLEEP_TICKS);
+  slept = timer_elapsed (start);
+  intr_cnt = timer_interrupts () - intr_start;
+
+  if (slept < SLEEP_TICKS)
+    fail ("woke up after %lld of %d ticks", (long long) slept, SLEEP_TICKS);
+  msg ("slept %d ticks", SLEEP_TICKS);
+
+  if (intr_cnt > MAX_INTERRUPTS)
+    fail ("took %lld timer interrupts over %lld idle ticks",
+          (long long) intr_cnt, (long long) slept);
+  msg ("took at most %d timer interrupts", MAX_INTERRUPTS);
+}
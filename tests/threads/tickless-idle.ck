@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(tickless-idle) begin
+(tickless-idle) slept 500 ticks
+(tickless-idle) took at most 10 timer interrupts
+(tickless-idle) end
+EOF
+pass;
@@ -0,0 +1,74 @@
+/* Measures fork/exit throughput.
+
+   Forks children that exit immediately, one at a time, and waits
+   for each of them, first with no files open and then with a few
+   files open so that the descriptor table has to be copied.
+   Costs are reported in TSC cycles per fork+exit+wait.
+
+   Each child checks that every descriptor we had open is open in
+   it too, and exits with status 1 otherwise, which fails the test.
+   The timings themselves are only printed. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FORK_CNT 50
+#define OPEN_CNT 8
+
+static int fds[OPEN_CNT];
+static int fd_cnt;
+
+static uint64_t rdtsc (void);
+static void measure (const char *what);
+
+void
+test_main (void) 
+{
+  int i;
+
+  measure ("no open files");
+
+  for (i = 0; i < OPEN_CNT; i++)
+    CHECK ((fds[fd_cnt++] = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  measure ("8 open files");
+}
+
+static void
+measure (const char *what) 
+{
+  uint64_t start, elapsed;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < FORK_CNT; i++) 
+    {
+      pid_t pid = fork ("child");
+      if (pid == 0)
+        {
+          int j;
+
+          for (j = 0; j < fd_cnt; j++)
+            if (filesize (fds[j]) <= 0)
+              exit (1);
+          exit (0);
+        }
+      if (pid < 0)
+        fail ("fork %d failed", i);
+      if (wait (pid) != 0)
+        fail ("child %d exited abnormally", i);
+    }
+  elapsed = rdtsc () - start;
+
+  msg ("%s: %d forks, %llu cycles per fork", what, FORK_CNT,
+       (unsigned long long) (elapsed / FORK_CNT));
+}
+
+static uint64_t
+rdtsc (void) 
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
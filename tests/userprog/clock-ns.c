@@ -0,0 +1,33 @@
+/* Reads clock_ns() over and over and checks that it never goes
+   backward and that it advances in steps much smaller than a
+   timer tick. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* One timer tick at 100 Hz, in nanoseconds. */
+#define TICK_NS 10000000ULL
+
+void
+test_main (void) 
+{
+  uint64_t first = clock_ns ();
+  uint64_t prev = first;
+  uint64_t min_step = UINT64_MAX;
+  int i;
+
+  for (i = 0; i < 100000 && prev - first < 2 * TICK_NS; i++)
+    {
+      uint64_t now = clock_ns ();
+      if (now < prev)
+        fail ("clock went backward: %llu after %llu",
+              (unsigned long long) now, (unsigned long long) prev);
+      if (now != prev && now - prev < min_step)
+        min_step = now - prev;
+      prev = now;
+    }
+
+  CHECK (prev > first, "clock advances");
+  CHECK (min_step < TICK_NS, "clock resolution is finer than a tick");
+}
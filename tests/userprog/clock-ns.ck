@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(clock-ns) begin
+(clock-ns) clock advances
+(clock-ns) clock resolution is finer than a tick
+(clock-ns) end
+clock-ns: exit(0)
+EOF
+pass;
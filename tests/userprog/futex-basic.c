@@ -0,0 +1,18 @@
+/* Calls futex in the ways that must return without sleeping: a
+   wait on a word that no longer holds the expected value, a wake
+   with nobody sleeping, and an unknown operation. */
+
+#include <syscall.h>
+#include <syscall-nr.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int word = 1;
+
+  CHECK (futex (&word, FUTEX_WAIT, 0) == -1, "wait on changed word");
+  CHECK (futex (&word, FUTEX_WAKE, 1) == 0, "wake with no sleepers");
+  CHECK (futex (&word, 42, 0) == -1, "unknown operation");
+}
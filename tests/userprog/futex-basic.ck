@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-basic) begin
+(futex-basic) wait on changed word
+(futex-basic) wake with no sleepers
+(futex-basic) unknown operation
+(futex-basic) end
+futex-basic: exit(0)
+EOF
+pass;
@@ -0,0 +1,25 @@
+/* Takes and releases a futex-based mutex without contention, which
+   must not need the kernel: the lock word goes straight between
+   free and locked, and never to contended. */
+
+#include <mutex.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct mutex lock = MUTEX_INITIALIZER;
+
+void
+test_main (void) 
+{
+  mutex_lock (&lock);
+  CHECK (lock.state == MUTEX_LOCKED, "lock");
+  CHECK (!mutex_trylock (&lock), "trylock fails while held");
+  mutex_unlock (&lock);
+  CHECK (lock.state == MUTEX_FREE, "unlock");
+
+  CHECK (mutex_trylock (&lock), "trylock");
+  CHECK (lock.state == MUTEX_LOCKED, "locked by trylock");
+  mutex_unlock (&lock);
+  CHECK (lock.state == MUTEX_FREE, "unlock again");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-mutex) begin
+(futex-mutex) lock
+(futex-mutex) trylock fails while held
+(futex-mutex) unlock
+(futex-mutex) trylock
+(futex-mutex) locked by trylock
+(futex-mutex) unlock again
+(futex-mutex) end
+futex-mutex: exit(0)
+EOF
+pass;
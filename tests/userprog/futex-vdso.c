@@ -0,0 +1,19 @@
+/* Tries to sleep on a word in the read-only clock page that the
+   kernel maps into every process.  That page is kernel data, not
+   memory that processes share, so it cannot hold a futex word.
+   The process must be terminated with -1 exit code. */
+
+#include <syscall.h>
+#include <syscall-nr.h>
+#include <vdso-data.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int *word = (int *) &((struct vdso_time *) VDSO_ADDR)->timer_freq;
+
+  futex (word, FUTEX_WAIT, *word);
+  fail ("should have exited with -1");
+}
@@ -0,0 +1,9 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-vdso) begin
+futex-vdso: exit(-1)
+EOF
+pass;
@@ -0,0 +1,32 @@
+/* Spins in user mode for a few timer ticks and checks that the
+   process's scheduling statistics account for it. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Four timer ticks at 100 Hz, in nanoseconds. */
+#define SPIN_NS 40000000ULL
+
+void
+test_main (void) 
+{
+  struct sched_stats before, after;
+  uint64_t start;
+  uint32_t waits = 0;
+  int i;
+
+  CHECK (sched_stats (0, &before) == 0, "read own statistics");
+
+  start = clock_ns ();
+  while (clock_ns () - start < SPIN_NS)
+    continue;
+
+  CHECK (sched_stats (0, &after) == 0, "read them again");
+  CHECK (after.user_ticks + after.kernel_ticks
+         > before.user_ticks + before.kernel_ticks, "ticks were accounted");
+  for (i = 0; i < SCHED_HIST_BUCKETS; i++)
+    waits += after.runq_wait_hist[i];
+  CHECK (waits > 0, "run queue waits were recorded");
+  CHECK (sched_stats (12345, &after) == -1, "unknown pid fails");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sched-stats) begin
+(sched-stats) read own statistics
+(sched-stats) read them again
+(sched-stats) ticks were accounted
+(sched-stats) run queue waits were recorded
+(sched-stats) unknown pid fails
+(sched-stats) end
+sched-stats: exit(0)
+EOF
+pass;
@@ -0,0 +1,24 @@
+/* Reads the kernel data pages through the vdso_*() helpers and
+   checks them against the corresponding system calls. */
+
+#include <syscall.h>
+#include <vdso.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  uint64_t before, now, after;
+
+  CHECK (vdso_getpid () > 0, "pid is valid");
+  CHECK (vdso_cpu () >= 0, "cpu is valid");
+
+  before = vdso_clock_ns ();
+  now = clock_ns ();
+  after = vdso_clock_ns ();
+  CHECK (before <= now && now <= after, "clock agrees with clock_ns");
+
+  CHECK (vdso_ticks () * 10000000ULL <= clock_ns (),
+         "ticks agree with clock_ns");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(vdso-read) begin
+(vdso-read) pid is valid
+(vdso-read) cpu is valid
+(vdso-read) clock agrees with clock_ns
+(vdso-read) ticks agree with clock_ns
+(vdso-read) end
+vdso-read: exit(0)
+EOF
+pass;
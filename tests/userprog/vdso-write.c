@@ -0,0 +1,13 @@
+/* Tries to write to the read-only kernel data page.
+   The process must be terminated with -1 exit code. */
+
+#include <vdso-data.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  ((struct vdso_proc *) VDSO_PROC_ADDR)->pid = 0;
+  fail ("should have exited with -1");
+}
@@ -0,0 +1,66 @@
+/* Sleeps two child processes on a futex word and wakes them from
+   the parent.
+
+   The word lives in a file mapping that the parent makes before it
+   forks, and file mappings are shared across fork(), so all three
+   processes see the word at the same frame.  Each child counts
+   itself in and sleeps for as long as the word holds 0, which it
+   does throughout, so a child can only be woken by FUTEX_WAKE.
+   Once both children are in, the parent keeps waking until both
+   have been woken, checking that no wake counts more sleepers than
+   there are, then waits for both to exit. */
+
+#include <syscall.h>
+#include <syscall-nr.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 2
+#define ACTUAL ((void *) 0x10000000)
+
+struct shared
+  {
+    int word;                   /* Futex word, always 0. */
+    int ready;                  /* Children about to sleep. */
+  };
+
+void
+test_main (void) 
+{
+  struct shared *s = ACTUAL;
+  pid_t pids[CHILD_CNT];
+  int handle;
+  int woken = 0;
+  int i;
+
+  CHECK (create ("shared", sizeof *s), "create \"shared\"");
+  CHECK ((handle = open ("shared")) > 1, "open \"shared\"");
+  CHECK (mmap (ACTUAL, sizeof *s, 1, handle, 0) != MAP_FAILED,
+         "mmap \"shared\"");
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      pids[i] = fork ("child");
+      if (pids[i] == 0)
+        {
+          __atomic_add_fetch (&s->ready, 1, __ATOMIC_SEQ_CST);
+          exit (futex (&s->word, FUTEX_WAIT, 0) == 0 ? 81 : 1);
+        }
+      CHECK (pids[i] > 0, "fork child %d", i);
+    }
+
+  while (__atomic_load_n (&s->ready, __ATOMIC_SEQ_CST) < CHILD_CNT)
+    continue;
+  while (woken < CHILD_CNT)
+    {
+      int cnt = futex (&s->word, FUTEX_WAKE, CHILD_CNT);
+      if (cnt < 0 || woken + cnt > CHILD_CNT)
+        fail ("FUTEX_WAKE woke %d, %d already woken", cnt, woken);
+      woken += cnt;
+    }
+  msg ("woke %d children", woken);
+
+  for (i = 0; i < CHILD_CNT; i++)
+    CHECK (wait (pids[i]) == 81, "wait for child %d", i);
+  CHECK (futex (&s->word, FUTEX_WAKE, CHILD_CNT) == 0, "no sleepers left");
+}
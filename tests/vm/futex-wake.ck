@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(futex-wake) begin
+(futex-wake) create "shared"
+(futex-wake) open "shared"
+(futex-wake) mmap "shared"
+(futex-wake) fork child 0
+(futex-wake) fork child 1
+(futex-wake) woke 2 children
+(futex-wake) wait for child 0
+(futex-wake) wait for child 1
+(futex-wake) no sleepers left
+(futex-wake) end
+EOF
+pass;
@@ -0,0 +1,22 @@
+/* Verifies that mapping over the read-only kernel data pages is
+   disallowed, whether the mapping starts on one of them or only
+   runs into them from below. */
+
+#include <syscall.h>
+#include <vdso-data.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap ((void *) VDSO_ADDR, 4096, 0, handle, 0) == MAP_FAILED,
+         "try to mmap over clock page");
+  CHECK (mmap ((void *) VDSO_PROC_ADDR, 4096, 0, handle, 0) == MAP_FAILED,
+         "try to mmap over process page");
+  CHECK (mmap ((void *) (VDSO_ADDR - 4096), 8192, 0, handle, 0)
+         == MAP_FAILED, "try to mmap into clock page from below");
+}
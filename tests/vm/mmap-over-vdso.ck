@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-over-vdso) begin
+(mmap-over-vdso) open "sample.txt"
+(mmap-over-vdso) try to mmap over clock page
+(mmap-over-vdso) try to mmap over process page
+(mmap-over-vdso) try to mmap into clock page from below
+(mmap-over-vdso) end
+EOF
+pass;
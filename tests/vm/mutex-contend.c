@@ -0,0 +1,88 @@
+/* Runs CHILD_CNT child processes that each add to a counter
+   ITER_CNT times under a futex-based mutex, with the lock and the
+   counter in a file mapping that they share with the parent.
+
+   The parent holds the lock while it forks the children and until
+   it sees the lock word go to MUTEX_CONTENDED, so at least one
+   child has to sleep in FUTEX_WAIT and be woken by mutex_unlock().
+   Each increment reads the counter, spins for a while and writes
+   it back, so two children inside the lock at once would lose an
+   update.  Once all children have exited, the counter must be
+   CHILD_CNT * ITER_CNT and the lock free. */
+
+#include <mutex.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 4
+#define ITER_CNT 50
+#define SPIN_CNT 20000
+#define ACTUAL ((void *) 0x10000000)
+
+struct shared
+  {
+    struct mutex lock;
+    int counter;                /* Protected by LOCK. */
+  };
+
+static void child (struct shared *);
+
+void
+test_main (void) 
+{
+  struct shared *s = ACTUAL;
+  pid_t pids[CHILD_CNT];
+  int handle;
+  int i;
+
+  CHECK (create ("shared", sizeof *s), "create \"shared\"");
+  CHECK ((handle = open ("shared")) > 1, "open \"shared\"");
+  CHECK (mmap (ACTUAL, sizeof *s, 1, handle, 0) != MAP_FAILED,
+         "mmap \"shared\"");
+
+  mutex_init (&s->lock);
+  mutex_lock (&s->lock);
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      pids[i] = fork ("child");
+      if (pids[i] == 0)
+        child (s);
+      CHECK (pids[i] > 0, "fork child %d", i);
+    }
+
+  /* Let go only once somebody waits for the lock. */
+  while (__atomic_load_n (&s->lock.state, __ATOMIC_SEQ_CST)
+         != MUTEX_CONTENDED)
+    continue;
+  msg ("lock is contended");
+  mutex_unlock (&s->lock);
+
+  for (i = 0; i < CHILD_CNT; i++)
+    CHECK (wait (pids[i]) == 0, "wait for child %d", i);
+  if (s->counter != CHILD_CNT * ITER_CNT)
+    fail ("counter is %d, not %d", s->counter, CHILD_CNT * ITER_CNT);
+  msg ("counter is %d", s->counter);
+  CHECK (s->lock.state == MUTEX_FREE, "lock is free");
+}
+
+/* Adds to S's counter ITER_CNT times, then exits. */
+static void
+child (struct shared *s)
+{
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      volatile int spin;
+      int counter;
+
+      mutex_lock (&s->lock);
+      counter = s->counter;
+      for (spin = 0; spin < SPIN_CNT; spin++)
+        continue;
+      s->counter = counter + 1;
+      mutex_unlock (&s->lock);
+    }
+  exit (0);
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mutex-contend) begin
+(mutex-contend) create "shared"
+(mutex-contend) open "shared"
+(mutex-contend) mmap "shared"
+(mutex-contend) fork child 0
+(mutex-contend) fork child 1
+(mutex-contend) fork child 2
+(mutex-contend) fork child 3
+(mutex-contend) lock is contended
+(mutex-contend) wait for child 0
+(mutex-contend) wait for child 1
+(mutex-contend) wait for child 2
+(mutex-contend) wait for child 3
+(mutex-contend) counter is 200
+(mutex-contend) lock is free
+(mutex-contend) end
+EOF
+pass;
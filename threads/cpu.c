@@ -0,0 +1,239 @@
+#include "threads/cpu.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/init.h"
+#include "threads/lapic.h"
+#include "threads/loader.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/*------------------------- [P1] SMP --------------------------*/
+/* CPUs are discovered from the Intel MultiProcessor Specification
+   tables that the BIOS leaves in low memory.  See [MP] for the
+   layout of the structures below.
+
+   The bootstrap processor (cpus[0]) boots the kernel alone.  Once
+   the scheduler and the local APIC timer are running,
+   cpu_start_aps() wakes the application processors through their
+   local APICs, and each one joins the scheduler as an idle CPU
+   that steals work from the others.  Run `pintos --smp N' to
+   simulate N CPUs. */
+
+/* MP floating pointer structure. */
+struct mp_fp {
+	char signature[4];          /* "_MP_". */
+	uint32_t config;            /* Physical address of MP config table. */
+	uint8_t length;             /* Length in 16-byte units. */
+	uint8_t spec_rev;
+	uint8_t checksum;           /* All bytes must add up to 0. */
+	uint8_t type;               /* Default configuration type, or 0. */
+	uint8_t imcrp;
+	uint8_t reserved[3];
+} __attribute__((packed));
+
+/* MP configuration table header. */
+struct mp_config {
+	char signature[4];          /* "PCMP". */
+	uint16_t length;            /* Length of base table, in bytes. */
+	uint8_t version;
+	uint8_t checksum;           /* All bytes must add up to 0. */
+	char product[20];
+	uint32_t oem_table;
+	uint16_t oem_length;
+	uint16_t entry_cnt;         /* # of entries after the header. */
+	uint32_t lapic_addr;        /* Physical address of local APICs. */
+	uint16_t ext_length;
+	uint8_t ext_checksum;
+	uint8_t reserved;
+} __attribute__((packed));
+
+/* MP configuration table processor entry. */
+struct mp_proc {
+	uint8_t type;               /* MP_PROC. */
+	uint8_t apic_id;            /* Local APIC ID. */
+	uint8_t version;
+	uint8_t flags;              /* MP_PROC_* flags. */
+	uint8_t signature[4];
+	uint32_t feature;
+	uint8_t reserved[8];
+} __attribute__((packed));
+
+/* MP configuration table entry types.  Processor entries are 20
+   bytes long, every other kind is 8. */
+#define MP_PROC 0x00
+#define MP_PROC_ENABLED 0x01        /* Processor is usable. */
+#define MP_PROC_BSP 0x02            /* Bootstrap processor. */
+
+struct cpu cpus[NCPU_MAX];
+int cpu_cnt = 1;
+
+/* Start-up code for the application processors, and what it hands
+   them.  See threads/ap-start.S. */
+extern const uint8_t ap_start[], ap_start_end[];
+extern uint64_t ap_boot_cr3, ap_boot_rsp;
+
+/* Milliseconds to wait for an AP to come online. */
+#define AP_START_TIMEOUT 100
+
+static struct mp_fp *mp_search (void);
+static struct mp_fp *mp_search_range (uint64_t pa, size_t len);
+static uint8_t checksum (const void *, size_t len);
+
+/* Finds the CPUs in the system and initializes their per-CPU
+   state.  Until this is called, cpus[0] stands for the one CPU
+   that is running. */
+void
+cpu_init (void) {
+	struct mp_fp *fp = mp_search ();
+	struct mp_config *conf;
+	uint8_t *p, *end;
+	int present = 0;
+
+	for (int i = 0; i < NCPU_MAX; i++)
+		cpus[i].id = i;
+	cpus[0].online = true;
+
+	if (fp == NULL || fp->config == 0) {
+		printf ("cpu: no MP configuration table, assuming 1 CPU.\n");
+		return;
+	}
+	conf = ptov (fp->config);
+	if (memcmp (conf->signature, "PCMP", 4) || checksum (conf, conf->length)) {
+		printf ("cpu: bad MP configuration table, assuming 1 CPU.\n");
+		return;
+	}
+
+	cpu_cnt = 1; // cpus[0]은 BSP 자리로 비워둔다.
+	p = (uint8_t *) (conf + 1);
+	end = (uint8_t *) conf + conf->length;
+	for (int i = 0; i < conf->entry_cnt && p < end; i++) {
+		if (*p != MP_PROC) {
+			p += 8;
+			continue;
+		}
+
+		struct mp_proc *proc = (struct mp_proc *) p;
+		p += sizeof *proc;
+		if (!(proc->flags & MP_PROC_ENABLED))
+			continue;
+		present++;
+		if (proc->flags & MP_PROC_BSP)
+			cpus[0].apic_id = proc->apic_id;
+		else if (cpu_cnt < NCPU_MAX)
+			cpus[cpu_cnt++].apic_id = proc->apic_id;
+	}
+
+	printf ("cpu: %d CPU(s) present, %d online.\n",
+			present, cpu_online_cnt ());
+}
+
+/* Starts the application processors found by cpu_init(), one at
+   a time, with the INIT-SIPI-SIPI sequence of [IA32-v3a] 8.4.4.1.
+   Each one starts on an idle thread of its own and comes online
+   once ap_main() has set it up.  Must be called after
+   timer_calibrate(), since an AP's tick comes from its local APIC
+   timer. */
+void
+cpu_start_aps (void) {
+	if (cpu_cnt == 1 || !lapic_present ())
+		return;
+
+	memcpy (ptov (AP_START_ADDR), ap_start, ap_start_end - ap_start);
+	ap_boot_cr3 = vtop (base_pml4);
+	for (int i = 1; i < cpu_cnt; i++) {
+		struct cpu *c = &cpus[i];
+		struct thread *t = thread_init_ap (c);
+
+		if (t == NULL) {
+			printf ("cpu: out of memory starting CPU %d.\n", i);
+			break;
+		}
+		ap_boot_rsp = (uint64_t) t + PGSIZE; // 유휴 스레드의 스택으로 시작한다.
+
+		lapic_send_init (c->apic_id);
+		timer_msleep (10);
+		lapic_send_startup (c->apic_id, AP_START_ADDR);
+		timer_usleep (200);
+		if (!c->online) // 첫 SIPI를 놓쳤을 수 있다. 이미 깨어났다면 무시된다.
+			lapic_send_startup (c->apic_id, AP_START_ADDR);
+
+		for (int ms = 0; !c->online && ms < AP_START_TIMEOUT; ms++)
+			timer_msleep (1);
+		if (!c->online) { // 늦게 깨어나 다음 AP의 스택을 쓰지 않도록 여기서 멈춘다.
+			printf ("cpu: CPU %d (APIC ID %d) did not start.\n", i, c->apic_id);
+			break;
+		}
+	}
+	printf ("cpu: %d CPU(s) online.\n", cpu_online_cnt ());
+}
+
+/* Returns the CPU that the caller is running on.
+   The running thread records its CPU in schedule(), so this is
+   just a load through the thread structure at the bottom of the
+   stack (see running_thread() in thread.c).  Until thread_init()
+   has made the boot code a thread and set cpus[0].online, only
+   the bootstrap processor runs.  Interrupts should be off, or the
+   thread could migrate before the answer is used. */
+struct cpu *
+this_cpu (void) {
+	struct thread *t = (struct thread *) pg_round_down (rrsp ());
+
+	if (!cpus[0].online)
+		return &cpus[0];
+	return t->cpu;
+}
+
+/* Returns the number of CPUs running kernel code. */
+int
+cpu_online_cnt (void) {
+	int cnt = 0;
+
+	for (int i = 0; i < cpu_cnt; i++)
+		if (cpus[i].online)
+			cnt++;
+	return cnt;
+}
+
+/* Looks for the MP floating pointer structure in the three places
+   [MP] 4.1 lists: the first KB of the EBDA, the last KB of base
+   memory, and the BIOS ROM between 0xe0000 and 0xfffff. */
+static struct mp_fp *
+mp_search (void) {
+	uint8_t *bda = ptov (0x400);
+	uint64_t ebda = ((bda[0x0f] << 8) | bda[0x0e]) << 4;
+	uint64_t base_kb = (bda[0x14] << 8) | bda[0x13];
+	struct mp_fp *fp;
+
+	if (ebda != 0 && (fp = mp_search_range (ebda, 1024)) != NULL)
+		return fp;
+	if ((fp = mp_search_range (base_kb * 1024 - 1024, 1024)) != NULL)
+		return fp;
+	return mp_search_range (0xe0000, 0x20000);
+}
+
+/* Looks for an MP floating pointer structure in the LEN bytes
+   starting at physical address PA. */
+static struct mp_fp *
+mp_search_range (uint64_t pa, size_t len) {
+	uint8_t *p = ptov (pa);
+	uint8_t *end = p + len;
+
+	for (; p + sizeof (struct mp_fp) <= end; p += 16)
+		if (!memcmp (p, "_MP_", 4) && !checksum (p, sizeof (struct mp_fp)))
+			return (struct mp_fp *) p;
+	return NULL;
+}
+
+/* Returns the sum of the LEN bytes at P, modulo 256. */
+static uint8_t
+checksum (const void *p_, size_t len) {
+	const uint8_t *p = p_;
+	uint8_t sum = 0;
+
+	while (len-- > 0)
+		sum += *p++;
+	return sum;
+}
@@ -13,20 +13,27 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/lapic.h"
+#include "threads/lockstat.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
+#include "threads/profile.h"
 #include "threads/pte.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
+#include "userprog/vdso.h"
 #endif
 #include "tests/threads/tests.h"
 #ifdef VM
@@ -63,6 +70,7 @@ static void print_stats (void);
 
 
 int main (void) NO_RETURN;
+void ap_main (void) NO_RETURN;
 
 /* Pintos main program. */
 int
@@ -87,6 +95,11 @@ main (void) {
 	malloc_init ();
 	paging_init (mem_end);
 
+	/* Find the other CPUs. */
+	cpu_init ();
+	trace_init ();
+	profile_init ();
+
 #ifdef USERPROG
 	tss_init ();
 	gdt_init ();
@@ -94,18 +107,24 @@ main (void) {
 
 	/* Initialize interrupt handlers. */
 	intr_init ();
+	lapic_init ();
 	timer_init ();
 	kbd_init ();
 	input_init ();
 #ifdef USERPROG
 	exception_init ();
 	syscall_init ();
+	vdso_init ();
 #endif
 	/* Start thread scheduler and enable interrupts. */
 	thread_start ();
+	palloc_zero_start ();
 	serial_init_queue ();
 	timer_calibrate ();
 
+	/* Start the other CPUs. */
+	cpu_start_aps ();
+
 #ifdef FILESYS
 	/* Initialize file system. */
 	disk_init ();
@@ -127,6 +146,25 @@ main (void) {
 	thread_exit ();
 }
 
+/* Application processor main program, called by ap-start.S with
+   interrupts off, on the stack of the idle thread that
+   cpu_start_aps() set up for this CPU.  Only per-CPU state is set
+   up here; everything shared was set up by main(). */
+void
+ap_main (void) {
+#ifdef USERPROG
+	tss_init ();
+	gdt_init ();
+#endif
+	intr_init_ap ();
+	lapic_init ();
+#ifdef USERPROG
+	syscall_init_cpu ();
+#endif
+	timer_init_ap ();
+	thread_start_ap ();
+}
+
 /* Clear BSS */
 static void
 bss_init (void) {
@@ -221,6 +259,18 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-lockstat"))
+			lockstat_enabled = true;
+		else if (!strcmp (name, "-tickless"))
+			timer_tickless = true;
+		else if (!strcmp (name, "-schedstat"))
+			thread_schedstat = true;
+		else if (!strcmp (name, "-trace"))
+			trace_enabled = true;
+		else if (!strcmp (name, "-profile"))
+			profile_enabled = true;
+		else if (!strcmp (name, "-kmemstat"))
+			kmemstat_enabled = true;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
@@ -272,6 +322,8 @@ run_actions (char **argv) {
 		{"rm", 2, fsutil_rm},
 		{"put", 2, fsutil_put},
 		{"get", 2, fsutil_get},
+		{"tracedump", 1, trace_dump},
+		{"profdump", 1, profile_dump},
 #endif
 		{NULL, 0, NULL},
 	};
@@ -319,6 +371,8 @@ usage (void) {
 			"Use these actions indirectly via `pintos' -g and -p options:\n"
 			"  put FILE           Put FILE into file system from scratch disk.\n"
 			"  get FILE           Get FILE from file system into scratch disk.\n"
+			"  tracedump          Write the -trace events to scratch disk.\n"
+			"  profdump           Write the -profile samples to scratch disk.\n"
 #endif
 			"\nOptions:\n"
 			"  -h                 Print this help message and power off.\n"
@@ -326,6 +380,12 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -lockstat          Print a lock contention report at power off.\n"
+			"  -tickless          Stop the timer tick while the CPU is idle.\n"
+			"  -schedstat         Print a scheduling latency report at power off.\n"
+			"  -trace             Record kernel events for the tracedump action.\n"
+			"  -profile           Sample the running code on every timer tick.\n"
+			"  -kmemstat          Print slab and malloc reports at power off.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
@@ -354,6 +414,10 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	palloc_print_stats ();
+	kmem_print_stats ();
+	malloc_print_stats ();
+	lockstat_print_stats ();
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
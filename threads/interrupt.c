@@ -6,6 +6,8 @@
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
+#include "threads/cpu.h"
+#include "threads/lapic.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
@@ -99,14 +101,16 @@ static const char *intr_names[INTR_CNT];
    pre-empted.  Handlers for external interrupts also may not
    sleep, although they may invoke intr_yield_on_return() to
    request that a new process be scheduled just before the
-   interrupt returns. */
-static bool in_external_intr;   /* Are we processing an external interrupt? */
-static bool yield_on_return;    /* Should we yield on interrupt return? */
+   interrupt returns.  Each CPU handles its own external
+   interrupts, so whether it is in one, and whether to yield on
+   return, is kept in its struct cpu. */
 
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
 
+static bool is_external (uint8_t vec_no);
+
 /* Interrupt handlers. */
 void intr_handler (struct intr_frame *args);
 
@@ -143,6 +147,11 @@ intr_enable (void) {
 	   Hardware Interrupts". */
 	asm volatile ("sti");
 
+	/* A lock released while interrupts were off may have asked
+	   for a yield; do it now that the critical section is over. */
+	if (old_level == INTR_OFF)
+		thread_run_deferred_yield ();
+
 	return old_level;
 }
 
@@ -203,6 +212,17 @@ intr_init (void) {
 	intr_names[19] = "#XF SIMD Floating-Point Exception";
 }
 
+/* Loads the IDT that intr_init() built, and this CPU's TSS, on an
+   application processor.  The PIC stays with the bootstrap
+   processor. */
+void
+intr_init_ap (void) {
+#ifdef USERPROG
+	ltr (SEL_TSS);
+#endif
+	lidt (&idt_desc);
+}
+
 /* Registers interrupt VEC_NO to invoke HANDLER with descriptor
    privilege level DPL.  Names the interrupt NAME for debugging
    purposes.  The interrupt handler will be invoked with
@@ -223,14 +243,27 @@ register_handler (uint8_t vec_no, int dpl, enum intr_level level,
 
 /* Registers external interrupt VEC_NO to invoke HANDLER, which
    is named NAME for debugging purposes.  The handler will
-   execute with interrupts disabled. */
+   execute with interrupts disabled.  VEC_NO is either a PIC
+   interrupt or a local APIC one (see threads/lapic.h). */
 void
 intr_register_ext (uint8_t vec_no, intr_handler_func *handler,
 		const char *name) {
-	ASSERT (vec_no >= 0x20 && vec_no <= 0x2f);
+	ASSERT (is_external (vec_no));
 	register_handler (vec_no, 0, INTR_OFF, handler, name);
 }
 
+/* Masks PIC interrupt VEC_NO, so that its device no longer
+   interrupts.  Used when the local APIC takes over the work of a
+   PIC interrupt. */
+void
+intr_mask_ext (uint8_t vec_no) {
+	ASSERT (vec_no >= 0x20 && vec_no <= 0x2f);
+	if (vec_no < 0x28)
+		outb (0x21, inb (0x21) | (1 << (vec_no - 0x20)));
+	else
+		outb (0xa1, inb (0xa1) | (1 << (vec_no - 0x28)));
+}
+
 /* Registers internal interrupt VEC_NO to invoke HANDLER, which
    is named NAME for debugging purposes.  The interrupt handler
    will be invoked with interrupt status LEVEL.
@@ -248,7 +281,7 @@ void
 intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
 		intr_handler_func *handler, const char *name)
 {
-	ASSERT (vec_no < 0x20 || vec_no > 0x2f);
+	ASSERT (!is_external (vec_no));
 	register_handler (vec_no, dpl, level, handler, name);
 }
 
@@ -256,7 +289,7 @@ intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
    and false at all other times. */
 bool
 intr_context (void) {
-	return in_external_intr;
+	return this_cpu ()->in_external_intr;
 }
 
 /* During processing of an external interrupt, directs the
@@ -266,7 +299,7 @@ intr_context (void) {
 void
 intr_yield_on_return (void) {
 	ASSERT (intr_context ());
-	yield_on_return = true;
+	this_cpu ()->yield_on_return = true;
 }
 
 /* 8259A Programmable Interrupt Controller. */
@@ -322,6 +355,14 @@ pic_end_of_interrupt (int irq) {
 	if (irq >= 0x28)
 		outb (0xa0, 0x20);
 }
+/* Returns true if VEC_NO is raised by a device outside the CPU's
+   core: by the PICs at 0x20...0x2f, or by the local APIC. */
+static bool
+is_external (uint8_t vec_no) {
+	return (vec_no >= 0x20 && vec_no <= 0x2f)
+		|| (vec_no >= LAPIC_TIMER_VEC && vec_no < LAPIC_SPURIOUS_VEC);
+}
+
 /* Interrupt handlers. */
 
 /* Handler for all interrupts, faults, and exceptions.  This
@@ -332,25 +373,27 @@ void
 intr_handler (struct intr_frame *frame) {
 	bool external;
 	intr_handler_func *handler;
+	struct cpu *c = this_cpu ();
 
 	/* External interrupts are special.
 	   We only handle one at a time (so interrupts must be off)
 	   and they need to be acknowledged on the PIC (see below).
 	   An external interrupt handler cannot sleep. */
-	external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+	external = is_external (frame->vec_no);
 	if (external) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (!intr_context ());
 
-		in_external_intr = true;
-		yield_on_return = false;
+		c->in_external_intr = true;
+		c->yield_on_return = false;
 	}
 
 	/* Invoke the interrupt's handler. */
 	handler = intr_handlers[frame->vec_no];
 	if (handler != NULL)
 		handler (frame);
-	else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f) {
+	else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f
+			|| frame->vec_no == LAPIC_SPURIOUS_VEC) {
 		/* There is no handler, but this interrupt can trigger
 		   spuriously due to a hardware fault or hardware race
 		   condition.  Ignore it. */
@@ -366,10 +409,13 @@ intr_handler (struct intr_frame *frame) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (intr_context ());
 
-		in_external_intr = false;
-		pic_end_of_interrupt (frame->vec_no);
+		c->in_external_intr = false;
+		if (frame->vec_no < 0x30)
+			pic_end_of_interrupt (frame->vec_no);
+		else
+			lapic_eoi ();
 
-		if (yield_on_return)
+		if (c->yield_on_return) // 양보한 뒤에는 다른 CPU에서 돌아올 수 있다.
 			thread_yield ();
 	}
 }
@@ -0,0 +1,210 @@
+#include "threads/lapic.h"
+#include <debug.h>
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/*------------------------- [P1] Local APIC --------------------------*/
+/* Every CPU has a local APIC that takes interrupts for it and has
+   a timer of its own.  Its registers are memory-mapped, 16 bytes
+   apart, in the page whose physical address is in the
+   IA32_APIC_BASE MSR.  See [IA32-v3a] chapter 10 "Advanced
+   Programmable Interrupt Controller (APIC)".
+
+   The 8259A PICs stay in charge of device interrupts: the BIOS
+   wires them to the bootstrap processor's LINT0 pin ("virtual
+   wire mode"), and they are acknowledged on the PIC, not here. */
+
+/* IA32_APIC_BASE MSR and its flags. */
+#define MSR_APIC_BASE 0x1b
+#define APIC_BASE_BSP 0x100         /* This CPU is the bootstrap processor. */
+#define APIC_BASE_ENABLE 0x800      /* Global enable. */
+#define APIC_BASE_ADDR 0xfffff000
+
+/* CPUID.01H:EDX bit that says a local APIC is present. */
+#define CPUID_APIC 0x200
+
+/* Register offsets. */
+#define LAPIC_ID 0x020              /* ID, in bits 24...31. */
+#define LAPIC_TPR 0x080             /* Task priority. */
+#define LAPIC_EOI 0x0b0             /* End of interrupt. */
+#define LAPIC_SVR 0x0f0             /* Spurious interrupt vector. */
+#define LAPIC_ESR 0x280             /* Error status. */
+#define LAPIC_ICR_LO 0x300          /* Interrupt command, low half. */
+#define LAPIC_ICR_HI 0x310          /* Interrupt command, destination. */
+#define LAPIC_LVT_TIMER 0x320       /* Local vector table: timer. */
+#define LAPIC_LVT_LINT0 0x350       /* Local vector table: LINT0 pin. */
+#define LAPIC_LVT_LINT1 0x360       /* Local vector table: LINT1 pin. */
+#define LAPIC_TIMER_INIT 0x380      /* Timer initial count. */
+#define LAPIC_TIMER_CUR 0x390       /* Timer current count. */
+#define LAPIC_TIMER_DIV 0x3e0       /* Timer divide configuration. */
+
+/* Register bits. */
+#define SVR_ENABLE 0x100            /* Software enable. */
+#define LVT_MASKED 0x10000          /* Interrupt masked. */
+#define LVT_PERIODIC 0x20000        /* Timer reloads its count. */
+#define LVT_NMI 0x400               /* Delivery mode: NMI. */
+#define LVT_EXTINT 0x700            /* Delivery mode: ExtINT (8259A). */
+#define TIMER_DIV_16 0x3            /* Timer counts at bus clock / 16. */
+#define ICR_INIT 0x500              /* Delivery mode: INIT. */
+#define ICR_STARTUP 0x600           /* Delivery mode: start-up (SIPI). */
+#define ICR_PENDING 0x1000          /* Delivery status: not sent yet. */
+#define ICR_ASSERT 0x4000           /* Level: assert. */
+#define ICR_LEVEL 0x8000            /* Trigger mode: level. */
+
+/* Local APIC registers, or a null pointer if there is none. */
+static volatile uint32_t *lapic;
+
+static uint32_t lapic_read (int reg);
+static void lapic_write (int reg, uint32_t value);
+static void send_icr (uint8_t apic_id, uint32_t icr);
+
+/* Enables the running CPU's local APIC.  The first call also maps
+   the APIC's registers into the kernel's address space, so it must
+   come after paging_init() and before any page table is copied
+   from base_pml4. */
+void
+lapic_init (void) {
+	uint32_t eax, ebx, ecx, edx;
+	uint64_t base;
+
+	cpuid (1, &eax, &ebx, &ecx, &edx);
+	if (!(edx & CPUID_APIC))
+		return;
+
+	base = read_msr (MSR_APIC_BASE);
+	if (!(base & APIC_BASE_ENABLE))
+		write_msr (MSR_APIC_BASE, base | APIC_BASE_ENABLE);
+
+	if (lapic == NULL) {
+		uint64_t pa = base & APIC_BASE_ADDR;
+		uint64_t *pte = pml4e_walk (base_pml4, (uint64_t) ptov (pa), 1);
+
+		ASSERT (pte != NULL);
+		*pte = pa | PTE_P | PTE_W | PTE_PCD | PTE_PWT; // 레지스터이므로 캐시하지 않는다.
+		invlpg ((uint64_t) ptov (pa));
+		lapic = ptov (pa);
+	}
+
+	lapic_write (LAPIC_SVR, SVR_ENABLE | LAPIC_SPURIOUS_VEC);
+	lapic_write (LAPIC_TIMER_DIV, TIMER_DIV_16);
+	lapic_timer_stop ();
+
+	/* BSP는 PIC 인터럽트를 LINT0로 계속 받고, AP는 받지 않는다. */
+	if (base & APIC_BASE_BSP)
+		lapic_write (LAPIC_LVT_LINT0, LVT_EXTINT);
+	else
+		lapic_write (LAPIC_LVT_LINT0, LVT_MASKED);
+	lapic_write (LAPIC_LVT_LINT1, LVT_NMI);
+
+	/* ESR는 읽기 전에 한 번 써야 한다. */
+	lapic_write (LAPIC_ESR, 0);
+	lapic_write (LAPIC_ESR, 0);
+	lapic_write (LAPIC_EOI, 0);
+	lapic_write (LAPIC_TPR, 0);
+}
+
+/* Returns true if lapic_init() found a local APIC. */
+bool
+lapic_present (void) {
+	return lapic != NULL;
+}
+
+/* Returns the running CPU's local APIC ID. */
+uint8_t
+lapic_id (void) {
+	ASSERT (lapic_present ());
+	return lapic_read (LAPIC_ID) >> 24;
+}
+
+/* Acknowledges the interrupt the local APIC is delivering. */
+void
+lapic_eoi (void) {
+	lapic_write (LAPIC_EOI, 0);
+}
+
+/* Makes the running CPU's local APIC timer interrupt on
+   LAPIC_TIMER_VEC every COUNT timer counts, starting now. */
+void
+lapic_timer_periodic (uint32_t count) {
+	ASSERT (count > 0);
+	lapic_write (LAPIC_LVT_TIMER, LVT_PERIODIC | LAPIC_TIMER_VEC);
+	lapic_write (LAPIC_TIMER_INIT, count);
+}
+
+/* Makes the running CPU's local APIC timer interrupt on
+   LAPIC_TIMER_VEC once, COUNT timer counts from now. */
+void
+lapic_timer_oneshot (uint32_t count) {
+	ASSERT (count > 0);
+	lapic_write (LAPIC_LVT_TIMER, LAPIC_TIMER_VEC);
+	lapic_write (LAPIC_TIMER_INIT, count);
+}
+
+/* Stops the running CPU's local APIC timer. */
+void
+lapic_timer_stop (void) {
+	lapic_write (LAPIC_LVT_TIMER, LVT_MASKED | LAPIC_TIMER_VEC);
+	lapic_write (LAPIC_TIMER_INIT, 0);
+}
+
+/* Returns the counts left until the running CPU's local APIC
+   timer next interrupts.  A one-shot timer that has gone off
+   reads 0. */
+uint32_t
+lapic_timer_count (void) {
+	return lapic_read (LAPIC_TIMER_CUR);
+}
+
+/* Sends interrupt vector VEC to the CPU whose local APIC ID is
+   APIC_ID. */
+void
+lapic_send_ipi (uint8_t apic_id, uint8_t vec) {
+	send_icr (apic_id, vec);
+}
+
+/* Sends an INIT to the CPU whose local APIC ID is APIC_ID, which
+   resets it into wait-for-SIPI state.  See [IA32-v3a] 8.4.4.1
+   "Typical BSP Initialization Sequence". */
+void
+lapic_send_init (uint8_t apic_id) {
+	send_icr (apic_id, ICR_INIT | ICR_LEVEL | ICR_ASSERT);
+	send_icr (apic_id, ICR_INIT | ICR_LEVEL); // 예전 APIC를 위해 INIT을 내린다.
+}
+
+/* Sends a start-up IPI to the CPU whose local APIC ID is
+   APIC_ID, which starts it in real mode at page-aligned physical
+   address PA, below 1 MB. */
+void
+lapic_send_startup (uint8_t apic_id, uint64_t pa) {
+	ASSERT (pa % PGSIZE == 0 && pa < 0x100000);
+	send_icr (apic_id, ICR_STARTUP | (pa / PGSIZE));
+}
+
+/* Writes ICR to the interrupt command register, addressed to
+   APIC_ID, and waits until the local APIC has sent it. */
+static void
+send_icr (uint8_t apic_id, uint32_t icr) {
+	enum intr_level old_level = intr_disable ();
+
+	ASSERT (lapic_present ());
+	lapic_write (LAPIC_ICR_HI, (uint32_t) apic_id << 24);
+	lapic_write (LAPIC_ICR_LO, icr);
+	while (lapic_read (LAPIC_ICR_LO) & ICR_PENDING)
+		continue;
+	intr_set_level (old_level);
+}
+
+static uint32_t
+lapic_read (int reg) {
+	return lapic[reg / sizeof *lapic];
+}
+
+static void
+lapic_write (int reg, uint32_t value) {
+	lapic[reg / sizeof *lapic] = value;
+	lapic_read (LAPIC_ID); // 쓰기가 끝날 때까지 기다린다.
+}
@@ -0,0 +1,132 @@
+#include "threads/lockstat.h"
+#include <debug.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "threads/spinlock.h"
+#include "threads/thread.h"
+
+/*------------------------- [P1] Lock Profiling --------------------------*/
+/* Maximum number of lock classes.  Locks initialized after the
+   table fills up are not profiled. */
+#define LOCK_CLASS_MAX 128
+
+/* Number of classes shown in the report. */
+#define LOCKSTAT_REPORT_MAX 20
+
+bool lockstat_enabled;
+
+static struct lock_class classes[LOCK_CLASS_MAX];
+static int class_cnt;
+
+/* Protects the class table and the counters.  Statically zeroed,
+   which is the released state, so that locks initialized before
+   thread_init() can be registered. */
+static struct spinlock lockstat_lock;
+
+static int compare_classes (const void *, const void *);
+
+/* Returns the class for locks (or semaphores, if IS_SEMA)
+   initialized with NAME, creating it if needed.  Returns a null
+   pointer, meaning "not profiled", if profiling is disabled, NAME
+   is null or the table is full. */
+struct lock_class *
+lockstat_register (const char *name, bool is_sema) {
+	struct lock_class *c = NULL;
+	enum intr_level old_level;
+
+	if (!lockstat_enabled || name == NULL)
+		return NULL;
+
+	old_level = spinlock_acquire (&lockstat_lock);
+	for (int i = 0; i < class_cnt; i++)
+		if (classes[i].is_sema == is_sema && !strcmp (classes[i].name, name)) {
+			c = &classes[i];
+			break;
+		}
+	if (c == NULL && class_cnt < LOCK_CLASS_MAX) {
+		c = &classes[class_cnt++];
+		c->name = name;
+		c->is_sema = is_sema;
+	}
+	spinlock_release (&lockstat_lock, old_level);
+	return c;
+}
+
+/* Records an acquisition of a lock of class C by the current
+   thread, which waited WAIT_TICKS if CONTENDED. */
+void
+lockstat_acquired (struct lock_class *c, bool contended, int64_t wait_ticks) {
+	enum intr_level old_level = spinlock_acquire (&lockstat_lock);
+
+	c->acquired++;
+	if (contended) {
+		struct thread *curr = thread_current ();
+
+		c->contended++;
+		c->wait_ticks += wait_ticks;
+		if (wait_ticks > c->max_wait_ticks)
+			c->max_wait_ticks = wait_ticks;
+		c->last_contender = curr->tid;
+		strlcpy (c->last_contender_name, curr->name, sizeof c->last_contender_name);
+	}
+	spinlock_release (&lockstat_lock, old_level);
+}
+
+/* Records that a lock of class C was held for HOLD_TICKS. */
+void
+lockstat_released (struct lock_class *c, int64_t hold_ticks) {
+	enum intr_level old_level = spinlock_acquire (&lockstat_lock);
+	if (hold_ticks > c->max_hold_ticks)
+		c->max_hold_ticks = hold_ticks;
+	spinlock_release (&lockstat_lock, old_level);
+}
+
+/* Prints the most contended lock classes, most contended first. */
+void
+lockstat_print_stats (void) {
+	static struct lock_class *sorted[LOCK_CLASS_MAX];
+	int cnt = 0;
+
+	if (!lockstat_enabled)
+		return;
+
+	for (int i = 0; i < class_cnt; i++)
+		if (classes[i].acquired > 0)
+			sorted[cnt++] = &classes[i];
+	qsort (sorted, cnt, sizeof *sorted, compare_classes);
+
+	printf ("Lock contention: %d lock classes in use\n", cnt);
+	printf ("  %10s %10s %10s %8s %8s  %-20s %s\n", "acquired", "contended",
+			"wait", "max wait", "max hold", "last contender", "lock");
+	for (int i = 0; i < cnt && i < LOCKSTAT_REPORT_MAX; i++) {
+		struct lock_class *c = sorted[i];
+		char contender[32] = "-";
+
+		if (c->contended > 0)
+			snprintf (contender, sizeof contender, "%s (%d)",
+					c->last_contender_name, c->last_contender);
+		if (c->is_sema)
+			printf ("  %10lld %10lld %10lld %8lld %8s  %-20s %s (sema)\n",
+					c->acquired, c->contended, c->wait_ticks, c->max_wait_ticks,
+					"-", contender, c->name);
+		else
+			printf ("  %10lld %10lld %10lld %8lld %8lld  %-20s %s\n",
+					c->acquired, c->contended, c->wait_ticks, c->max_wait_ticks,
+					c->max_hold_ticks, contender, c->name);
+	}
+}
+
+/* Orders lock classes by contended acquisitions, then by total
+   wait, both descending. */
+static int
+compare_classes (const void *a_, const void *b_) {
+	const struct lock_class *a = *(struct lock_class *const *) a_;
+	const struct lock_class *b = *(struct lock_class *const *) b_;
+
+	if (a->contended != b->contended)
+		return a->contended > b->contended ? -1 : 1;
+	if (a->wait_ticks != b->wait_ticks)
+		return a->wait_ticks > b->wait_ticks ? -1 : 1;
+	return 0;
+}
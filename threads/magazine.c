@@ -0,0 +1,92 @@
+#include "threads/magazine.h"
+#include <debug.h>
+#include <string.h>
+#include "threads/interrupt.h"
+
+/*------------------------- [P3] Magazines --------------------------*/
+/* Initializes RACK, whose magazines hold up to SIZE objects and
+   move BATCH of them at a time through REFILL and DRAIN. */
+void
+magazine_rack_init (struct magazine_rack *rack, int size, int batch,
+		magazine_refill_func *refill, magazine_drain_func *drain,
+		void *store) {
+	ASSERT (0 < batch && batch <= size && size <= MAGAZINE_MAX);
+	ASSERT (refill != NULL && drain != NULL);
+
+	memset (rack, 0, sizeof *rack);
+	rack->size = size;
+	rack->batch = batch;
+	rack->refill = refill;
+	rack->drain = drain;
+	rack->store = store;
+}
+
+/* Returns this CPU's magazine in RACK.  Interrupts must be off,
+   so that the magazine stays this CPU's while it is used. */
+static struct magazine *
+this_magazine (struct magazine_rack *rack) {
+	struct cpu *c = this_cpu ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	return &rack->mags[c != NULL ? c->id : 0];
+}
+
+/* Takes an object out of this CPU's magazine in RACK, refilling
+   the magazine from the store first if it is empty.  Returns a
+   null pointer if the store has nothing left either. */
+void *
+magazine_get (struct magazine_rack *rack) {
+	enum intr_level old_level = intr_disable ();
+	struct magazine *m = this_magazine (rack);
+	void *obj = NULL;
+
+	if (m->cnt > 0)
+		m->hits++;
+	else {
+		m->misses++;
+		m->cnt = rack->refill (rack->store, m->objs, rack->batch);
+		if (m->cnt > 0)
+			m->refills++;
+	}
+	if (m->cnt > 0)
+		obj = m->objs[--m->cnt];
+	intr_set_level (old_level);
+	return obj;
+}
+
+/* Puts OBJ into this CPU's magazine in RACK.  If the magazine is
+   full, first gives the BATCH objects put longest ago back to the
+   store. */
+void
+magazine_put (struct magazine_rack *rack, void *obj) {
+	enum intr_level old_level = intr_disable ();
+	struct magazine *m = this_magazine (rack);
+
+	if (m->cnt == rack->size) {
+		rack->drain (rack->store, m->objs, rack->batch);
+		memmove (m->objs, m->objs + rack->batch,
+				(m->cnt - rack->batch) * sizeof *m->objs);
+		m->cnt -= rack->batch;
+		m->drains++;
+	}
+	m->objs[m->cnt++] = obj;
+	m->puts++;
+	intr_set_level (old_level);
+}
+
+/* Adds up the counters of every magazine in RACK into *TOTAL.
+   The objects themselves are not copied. */
+void
+magazine_rack_stats (const struct magazine_rack *rack, struct magazine *total) {
+	memset (total, 0, sizeof *total);
+	for (int i = 0; i < NCPU_MAX; i++) {
+		const struct magazine *m = &rack->mags[i];
+
+		total->cnt += m->cnt;
+		total->hits += m->hits;
+		total->misses += m->misses;
+		total->refills += m->refills;
+		total->drains += m->drains;
+		total->puts += m->puts;
+	}
+}
@@ -5,17 +5,24 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/magazine.h"
 #include "threads/palloc.h"
-#include "threads/synch.h"
+#include "threads/slab.h"
+#include "threads/spinlock.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
 
-   The size of each request, in bytes, is rounded up to a power
-   of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
+   The size of each request, in bytes, is rounded up to a size
+   class and assigned to the "descriptor" that manages blocks of
+   that size.  Classes go up in steps of 16 bytes to 256 bytes,
+   then in quarter powers of 2 (320, 384, 448, 512, 640, ...), so
+   rounding wastes at most a fifth of a block above 256 bytes; a
+   table maps a size to its class in one step.  The descriptor keeps a list of
+   free blocks.  If the free list is nonempty, one of its blocks
+   is used to satisfy the request.
 
    Otherwise, a new page of memory, called an "arena", is
    obtained from the page allocator (if none is available,
@@ -24,22 +31,46 @@
    list.  Then we return one of the new blocks.
 
    When we free a block, we add it to its descriptor's free list.
-   But if the arena that the block was in now has no in-use
-   blocks, we remove all of the arena's blocks from the free list
-   and give the arena back to the page allocator.
-
-   We can't handle blocks bigger than 2 kB using this scheme,
+   If the arena that the block was in now has no in-use blocks,
+   and the descriptor already keeps ARENA_KEEP such empty arenas,
+   we remove all of the arena's blocks from the free list and give
+   the arena back to the page allocator.  Keeping a few empty
+   arenas around stops a workload whose allocation count goes up
+   and down from getting and freeing the same page over and over.
+
+   In front of the free lists, each CPU keeps a magazine of free
+   blocks of each class (see threads/magazine.h), so most calls to
+   malloc() and free() take no lock.
+
+   We can't handle blocks bigger than MAX_BLOCK_SIZE this way,
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
    the beginning of the allocated block's arena header. */
 
+/* Size classes are multiples of this many bytes. */
+#define CLASS_ALIGN 16
+
+/* Largest block size served from an arena.  Two blocks of this
+   size still fit in a page with the arena header. */
+#define MAX_BLOCK_SIZE 1792
+
+/* Number of size classes. */
+#define DESC_MAX 27
+
+/* Empty arenas a descriptor keeps instead of freeing them. */
+#define ARENA_KEEP 2
+
 /* Descriptor. */
 struct desc {
 	size_t block_size;          /* Size of each element in bytes. */
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
 	struct list free_list;      /* List of free blocks. */
-	struct lock lock;           /* Lock. */
+	struct spinlock lock;       /* Lock. */
+	size_t empty_cnt;           /* Arenas with all blocks on FREE_LIST. */
+	long long arenas_allocated; /* # of arenas taken from palloc. */
+	long long arenas_freed;     /* # of arenas given back. */
+	struct magazine_rack mags;  /* Per-CPU magazines. */
 };
 
 /* Magic number for detecting arena corruption. */
@@ -58,25 +89,54 @@ struct block {
 };
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[DESC_MAX]; /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Descriptor index for each request size, by
+   DIV_ROUND_UP (size, CLASS_ALIGN). */
+static uint8_t size_to_desc[MAX_BLOCK_SIZE / CLASS_ALIGN + 1];
+
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static magazine_refill_func desc_refill;
+static magazine_drain_func desc_drain;
 
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void) {
-	size_t block_size;
+	size_t block_size, step, i, idx;
 
-	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
+	for (block_size = CLASS_ALIGN; block_size <= MAX_BLOCK_SIZE;
+			block_size += step) {
 		struct desc *d = &descs[desc_cnt++];
 		ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
 		d->block_size = block_size;
 		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
 		list_init (&d->free_list);
-		lock_init (&d->lock);
+		spinlock_init (&d->lock);
+		magazine_rack_init (&d->mags, MAGAZINE_SIZE, MAGAZINE_BATCH,
+				desc_refill, desc_drain, d);
+
+		/* 256 바이트까지는 16씩, 그 뒤로는 2의 거듭제곱의 1/4씩 커진다. */
+		step = CLASS_ALIGN;
+		if (block_size >= 256)
+			step = (size_t) 1 << (63 - __builtin_clzll (block_size)) >> 2;
 	}
+
+	for (i = 0, idx = 0; i < sizeof size_to_desc; i++) {
+		while (descs[idx].block_size < i * CLASS_ALIGN)
+			idx++;
+		size_to_desc[i] = idx;
+	}
+}
+
+/* Returns the descriptor for SIZE-byte blocks, or a null pointer
+   if SIZE is too big for any descriptor. */
+static struct desc *
+size_desc (size_t size) {
+	if (size > MAX_BLOCK_SIZE)
+		return NULL;
+	return &descs[size_to_desc[DIV_ROUND_UP (size, CLASS_ALIGN)]];
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -84,7 +144,6 @@ malloc_init (void) {
 void *
 malloc (size_t size) {
 	struct desc *d;
-	struct block *b;
 	struct arena *a;
 
 	/* A null pointer satisfies a request for 0 bytes. */
@@ -93,10 +152,8 @@ malloc (size_t size) {
 
 	/* Find the smallest descriptor that satisfies a SIZE-byte
 	   request. */
-	for (d = descs; d < descs + desc_cnt; d++)
-		if (d->block_size >= size)
-			break;
-	if (d == descs + desc_cnt) {
+	d = size_desc (size);
+	if (d == NULL) {
 		/* SIZE is too big for any descriptor.
 		   Allocate enough pages to hold SIZE plus an arena. */
 		size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
@@ -112,35 +169,89 @@ malloc (size_t size) {
 		return a + 1;
 	}
 
-	lock_acquire (&d->lock);
-
-	/* If the free list is empty, create a new arena. */
-	if (list_empty (&d->free_list)) {
-		size_t i;
+	/* Take a block from this CPU's magazine, refilling it from the
+	   free list if it is empty. */
+	return magazine_get (&d->mags);
+}
 
-		/* Allocate a page. */
-		a = palloc_get_page (0);
-		if (a == NULL) {
-			lock_release (&d->lock);
-			return NULL;
+/* Takes up to CNT blocks of descriptor D_ for OBJS off its free
+   list, creating an arena whenever the list is empty.  Returns
+   the number of blocks taken.  Interrupts must be off. */
+static size_t
+desc_refill (void *d_, void **objs, size_t cnt) {
+	struct desc *d = d_;
+	size_t taken = 0;
+
+	spinlock_acquire (&d->lock);
+	while (taken < cnt) {
+		struct block *b;
+		struct arena *a;
+
+		/* If the free list is empty, create a new arena. */
+		if (list_empty (&d->free_list)) {
+			size_t i;
+
+			/* Allocate a page. */
+			a = palloc_get_page (0);
+			if (a == NULL)
+				break;
+
+			/* Initialize arena and add its blocks to the free list. */
+			a->magic = ARENA_MAGIC;
+			a->desc = d;
+			a->free_cnt = d->blocks_per_arena;
+			for (i = 0; i < d->blocks_per_arena; i++) {
+				struct block *b = arena_to_block (a, i);
+				list_push_back (&d->free_list, &b->free_elem);
+			}
+			d->empty_cnt++;
+			d->arenas_allocated++;
 		}
 
-		/* Initialize arena and add its blocks to the free list. */
-		a->magic = ARENA_MAGIC;
-		a->desc = d;
-		a->free_cnt = d->blocks_per_arena;
-		for (i = 0; i < d->blocks_per_arena; i++) {
-			struct block *b = arena_to_block (a, i);
-			list_push_back (&d->free_list, &b->free_elem);
-		}
+		/* Get a block from free list. */
+		b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
+		a = block_to_arena (b);
+		if (a->free_cnt-- == d->blocks_per_arena) // 비어 있던 아레나를 다시 쓰기 시작한다.
+			d->empty_cnt--;
+		objs[taken++] = b;
 	}
+	spinlock_release (&d->lock, INTR_OFF);
+	return taken;
+}
 
-	/* Get a block from free list and return it. */
-	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-	a = block_to_arena (b);
-	a->free_cnt--;
-	lock_release (&d->lock);
-	return b;
+/* Gives the CNT blocks in OBJS back to descriptor D_'s free list,
+   and frees arenas that become empty once D_ keeps ARENA_KEEP of
+   them.  Interrupts must be off. */
+static void
+desc_drain (void *d_, void **objs, size_t cnt) {
+	struct desc *d = d_;
+
+	spinlock_acquire (&d->lock);
+	for (size_t i = 0; i < cnt; i++) {
+		struct block *b = objs[i];
+		struct arena *a = block_to_arena (b);
+
+		/* Add block to free list. */
+		list_push_front (&d->free_list, &b->free_elem);
+
+		/* If the arena is now entirely unused, keep it or free it. */
+		if (++a->free_cnt >= d->blocks_per_arena) {
+			size_t j;
+
+			ASSERT (a->free_cnt == d->blocks_per_arena);
+			if (d->empty_cnt < ARENA_KEEP) {
+				d->empty_cnt++;
+				continue;
+			}
+			for (j = 0; j < d->blocks_per_arena; j++) {
+				struct block *b = arena_to_block (a, j);
+				list_remove (&b->free_elem);
+			}
+			palloc_free_page (a);
+			d->arenas_freed++;
+		}
+	}
+	spinlock_release (&d->lock, INTR_OFF);
 }
 
 /* Allocates and return A times B bytes initialized to zeroes.
@@ -167,9 +278,13 @@ calloc (size_t a, size_t b) {
 static size_t
 block_size (void *block) {
 	struct block *b = block;
-	struct arena *a = block_to_arena (b);
-	struct desc *d = a->desc;
+	struct arena *a;
+	struct desc *d;
 
+	if (kmem_owns (block))
+		return kmem_size (block);
+	a = block_to_arena (b);
+	d = a->desc;
 	return d != NULL ? d->block_size : PGSIZE * a->free_cnt - pg_ofs (block);
 }
 
@@ -197,9 +312,13 @@ realloc (void *old_block, size_t new_size) {
 }
 
 /* Frees block P, which must have been previously allocated with
-   malloc(), calloc(), or realloc(). */
+   malloc(), calloc(), or realloc(), or from an object cache. */
 void
 free (void *p) {
+	if (kmem_owns (p)) { // 슬랩 캐시에서 받은 객체는 그 캐시로 돌려준다.
+		kmem_free (p);
+		return;
+	}
 	if (p != NULL) {
 		struct block *b = p;
 		struct arena *a = block_to_arena (b);
@@ -213,24 +332,9 @@ free (void *p) {
 			memset (b, 0xcc, d->block_size);
 #endif
 
-			lock_acquire (&d->lock);
-
-			/* Add block to free list. */
-			list_push_front (&d->free_list, &b->free_elem);
-
-			/* If the arena is now entirely unused, free it. */
-			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
-
-				ASSERT (a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block (a, i);
-					list_remove (&b->free_elem);
-				}
-				palloc_free_page (a);
-			}
-
-			lock_release (&d->lock);
+			/* Put the block in this CPU's magazine, first making room
+			   by giving a batch back to the free list if it is full. */
+			magazine_put (&d->mags, b);
 		} else {
 			/* It's a big block.  Free its pages. */
 			palloc_free_multiple (a, a->free_cnt);
@@ -239,6 +343,38 @@ free (void *p) {
 	}
 }
 
+/* Returns the number of bytes of memory that malloc(SIZE) takes,
+   counting its share of the arena page or pages. */
+size_t
+malloc_footprint (size_t size) {
+	struct desc *d = size_desc (size);
+
+	if (d != NULL)
+		return PGSIZE / d->blocks_per_arena;
+	return DIV_ROUND_UP (size + sizeof (struct arena), PGSIZE) * PGSIZE;
+}
+
+/* Prints the descriptors that were used, if -kmemstat was given. */
+void
+malloc_print_stats (void) {
+	if (!kmemstat_enabled)
+		return;
+
+	printf ("Malloc size classes:\n");
+	printf ("  %5s %6s %9s %9s %11s %9s\n", "size", "/arena", "arenas",
+			"freed", "mag hits", "misses");
+	for (struct desc *d = descs; d < descs + desc_cnt; d++) {
+		struct magazine total;
+
+		magazine_rack_stats (&d->mags, &total);
+		if (total.hits + total.misses == 0)
+			continue;
+		printf ("  %5zu %6zu %9lld %9lld %11lld %9lld\n", d->block_size,
+				d->blocks_per_arena, d->arenas_allocated, d->arenas_freed,
+				total.hits, total.misses);
+	}
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b) {
@@ -6,10 +6,15 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <list.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/init.h"
 #include "threads/loader.h"
+#include "threads/magazine.h"
+#include "threads/spinlock.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -24,15 +29,81 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is a binary buddy allocator.  Free memory is kept as
+   blocks of 2**ORDER pages, aligned to their size relative to the
+   pool's base, on one free list per order.  An allocation takes a
+   block of the smallest order that fits, splitting a larger one
+   if needed, and gives back the pages past the request.  A freed
+   block is merged with its buddy, the other half of the block
+   one order up, for as long as that buddy is free too.  Both take
+   O(log n) steps instead of a scan over the whole pool.
+
+   Single pages, by far the most common request, first go through
+   a small per-CPU cache of free pages in front of each pool, a
+   magazine rack (see threads/magazine.h), so the common case
+   takes no lock; the cache refills from the pool and drains back
+   to it PCACHE_BATCH pages at a time.
+
+   Each pool also keeps up to ZERO_TARGET pages that are already
+   filled with zeros, so that palloc_get_page(PAL_ZERO) does not
+   have to clear a page while its caller waits.  When a pool runs
+   low, the idle thread wakes a kernel thread that clears pages to
+   refill it.  That thread goes back to sleep as soon as another
+   thread is ready to run, so whatever the priorities, zeroing
+   only uses time the CPU would otherwise spend idle. */
+
+/*------------------------- [P3] Buddy Allocator --------------------------*/
+/* Number of block orders: the largest block is 2**(PALLOC_ORDERS - 1)
+   pages (4 GB). */
+#define PALLOC_ORDERS 21
+
+/* Buddy allocator state of one page.  Only the first page of a
+   free block is on a free list. */
+struct page_info {
+	struct list_elem elem;          /* Element in free_lists[order]. */
+	int8_t order;                   /* Order if the first page of a free
+	                                   block, otherwise -1. */
+	bool cached;                    /* In a per-CPU page cache? */
+};
+
+/*------------------------- [P3] Per-CPU Page Cache --------------------------*/
+/* Pages a per-CPU cache holds at most, and moves to or from its
+   pool at once. */
+#define PCACHE_SIZE 32
+#define PCACHE_BATCH 16
+
+/* Pages in a per-CPU cache stay marked in the pool's used_map, so
+   their page_info's `cached' flag is what tells them apart from
+   pages in use. */
+
+/*------------------------- [P3] Pre-Zeroed Pages --------------------------*/
+/* Zeroed pages kept per pool.  A pool asks for more when it gets
+   down to fewer than ZERO_LOW of them. */
+#define ZERO_TARGET 64
+#define ZERO_LOW (ZERO_TARGET / 2)
 
 /* A memory pool. */
 struct pool {
-	struct lock lock;               /* Mutual exclusion. */
+	struct spinlock lock;           /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+	struct page_info *pages;        /* One entry per page. */
+	struct list free_lists[PALLOC_ORDERS]; /* Free blocks by order. */
+	struct magazine_rack caches;    /* Per-CPU caches of single pages. */
+	struct list zeroed;             /* Zeroed pages, through pages[].elem. */
+	size_t zeroed_cnt;              /* # of pages in ZEROED. */
+	long long zeroed_hits;          /* # of PAL_ZERO pages from ZEROED. */
+	long long zeroed_misses;        /* # of PAL_ZERO pages cleared on demand. */
+	bool zero_wanted;               /* Below ZERO_LOW since the last refill? */
 };
 
+/* Wakes up the zeroing thread.  Only the idle thread ups it. */
+static struct semaphore zero_sema;
+static bool zero_started;       /* Has palloc_zero_start() run? */
+static bool zero_awake;         /* Zeroing thread woken and not done? */
+
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
@@ -42,6 +113,19 @@ static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static void pool_release (struct pool *, size_t page_idx, size_t page_cnt);
+static int block_order (size_t page_cnt);
+static size_t buddy_alloc (struct pool *, int order);
+static void buddy_free_range (struct pool *, size_t page_idx, size_t page_cnt);
+static size_t page_cache_get (struct pool *);
+static void page_cache_put (struct pool *, size_t page_idx);
+static magazine_refill_func page_cache_refill;
+static magazine_drain_func page_cache_drain;
+static size_t pool_alloc (struct pool *, size_t page_cnt);
+static size_t zeroed_get (struct pool *);
+static bool zeroed_reclaim (struct pool *);
+static bool zeroed_fill (struct pool *);
+static thread_func zero_thread;
 
 /* multiboot info */
 struct multiboot_info {
@@ -223,12 +307,12 @@ split:
 			page_idx = pg_no (start) - pg_no (pool->base);
 			if ((uint64_t) pool_end < end) {
 				page_cnt = ((uint64_t) pool_end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool_release (pool, page_idx, page_cnt);
 				start = (uint64_t) pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t) end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool_release (pool, page_idx, page_cnt);
 			}
 		}
 	}
@@ -250,9 +334,34 @@ palloc_init (void) {
 	printf ("\text_mem: 0x%llx ~ 0x%llx (Usable: %'llu kB)\n",
 		  ext_mem.start, ext_mem.end, ext_mem.size / 1024);
 	populate_pools (&base_mem, &ext_mem);
+	sema_init (&zero_sema, 0);
 	return ext_mem.end;
 }
 
+/* Starts the thread that keeps the pools' zeroed pages topped
+   up.  Must be called after thread_start(). */
+void
+palloc_zero_start (void) {
+	thread_create ("palloc-zero", PRI_MIN, zero_thread, NULL);
+	zero_started = true;
+}
+
+/* Called by the idle thread, with interrupts off, when this CPU
+   has nothing else to run.  Wakes the zeroing thread if a pool
+   wants more zeroed pages.  Returns true if it did, in which case
+   the idle thread should let it run instead of halting. */
+bool
+palloc_idle (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!zero_started || zero_awake
+			|| (!kernel_pool.zero_wanted && !user_pool.zero_wanted))
+		return false;
+	zero_awake = true;
+	sema_up (&zero_sema);
+	return true;
+}
+
 /* Obtains and returns a group of PAGE_CNT contiguous free pages.
    If PAL_USER is set, the pages are obtained from the user pool,
    otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
@@ -262,19 +371,26 @@ palloc_init (void) {
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-
-	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-	lock_release (&pool->lock);
+	size_t page_idx = BITMAP_ERROR;
+	bool zeroed = false;
 	void *pages;
 
+	if (page_cnt == 1 && (flags & PAL_ZERO)) {
+		page_idx = zeroed_get (pool);
+		zeroed = page_idx != BITMAP_ERROR;
+	}
+	if (page_idx == BITMAP_ERROR)
+		page_idx = pool_alloc (pool, page_cnt);
+	if (page_idx == BITMAP_ERROR && zeroed_reclaim (pool)) // 메모리가 모자라면 0으로 채워둔 페이지도 내놓는다.
+		page_idx = pool_alloc (pool, page_cnt);
+
 	if (page_idx != BITMAP_ERROR)
 		pages = pool->base + PGSIZE * page_idx;
 	else
 		pages = NULL;
 
 	if (pages) {
-		if (flags & PAL_ZERO)
+		if ((flags & PAL_ZERO) && !zeroed)
 			memset (pages, 0, PGSIZE * page_cnt);
 	} else {
 		if (flags & PAL_ASSERT)
@@ -324,8 +440,33 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
-	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	if (page_cnt == 1)
+		page_cache_put (pool, page_idx);
+	else
+		pool_release (pool, page_idx, page_cnt);
+}
+
+/* Prints per-CPU page cache statistics. */
+void
+palloc_print_stats (void) {
+	struct pool *pools[] = { &kernel_pool, &user_pool };
+	const char *names[] = { "kernel", "user" };
+
+	printf ("Page cache:");
+	for (int i = 0; i < 2; i++) {
+		struct magazine t;
+
+		magazine_rack_stats (&pools[i]->caches, &t);
+		printf ("%s %s %lld%% hits (%lld refills, %lld drains)",
+				i > 0 ? "," : "", names[i],
+				t.hits + t.misses > 0 ? t.hits * 100 / (t.hits + t.misses) : 0,
+				t.refills, t.drains);
+	}
+	printf ("\n");
+	printf ("Zeroed pages: kernel %lld ready, %lld zeroed on demand;"
+			" user %lld ready, %lld zeroed on demand\n",
+			kernel_pool.zeroed_hits, kernel_pool.zeroed_misses,
+			user_pool.zeroed_hits, user_pool.zeroed_misses);
 }
 
 /* Frees the page at PAGE. */
@@ -342,15 +483,310 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
      and subtract it from the pool's size. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
 	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t info_pages = DIV_ROUND_UP (pgcnt * sizeof *p->pages, PGSIZE) * PGSIZE;
+	size_t i;
 
-	lock_init(&p->lock);
+	spinlock_init (&p->lock);
 	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
 	p->base = (void *) start;
+	p->pages = *bm_base + bm_pages; // buddy 정보는 비트맵 바로 뒤에 둔다.
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
+	for (i = 0; i < pgcnt; i++) {
+		p->pages[i].order = -1;
+		p->pages[i].cached = false;
+	}
+	for (i = 0; i < PALLOC_ORDERS; i++)
+		list_init (&p->free_lists[i]);
+	list_init (&p->zeroed);
+	p->zero_wanted = true;
+	magazine_rack_init (&p->caches, PCACHE_SIZE, PCACHE_BATCH,
+			page_cache_refill, page_cache_drain, p);
+
+	*bm_base += bm_pages + info_pages;
+}
+
+/* Returns the smallest order of a block that holds PAGE_CNT
+   pages. */
+static int
+block_order (size_t page_cnt) {
+	int order = 0;
+
+	while (((size_t) 1 << order) < page_cnt)
+		order++;
+	return order;
+}
+
+/* Puts the free block of 2**ORDER pages at PAGE_IDX on POOL's
+   free list. */
+static void
+block_push (struct pool *pool, size_t page_idx, int order) {
+	pool->pages[page_idx].order = order;
+	list_push_front (&pool->free_lists[order], &pool->pages[page_idx].elem);
+}
+
+/* Takes a free block of 2**ORDER pages out of POOL, splitting a
+   larger block if there is none of that order.  Returns the page
+   index of the block, or BITMAP_ERROR if no block is big enough.
+   POOL's lock must be held. */
+static size_t
+buddy_alloc (struct pool *pool, int order) {
+	struct page_info *info;
+	size_t page_idx;
+	int k;
+
+	for (k = order; k < PALLOC_ORDERS; k++)
+		if (!list_empty (&pool->free_lists[k]))
+			break;
+	if (k == PALLOC_ORDERS)
+		return BITMAP_ERROR;
+
+	info = list_entry (list_pop_front (&pool->free_lists[k]),
+			struct page_info, elem);
+	info->order = -1;
+	page_idx = info - pool->pages;
+	while (k > order) { // 쪼갠 블록의 위쪽 절반은 한 단계 낮은 리스트로 간다.
+		k--;
+		block_push (pool, page_idx + ((size_t) 1 << k), k);
+	}
+	return page_idx;
+}
+
+/* Returns the block of 2**ORDER pages at PAGE_IDX to POOL,
+   merging it with its buddy for as long as the buddy is a free
+   block of the same order.  POOL's lock must be held. */
+static void
+buddy_free (struct pool *pool, size_t page_idx, int order) {
+	size_t page_cnt = bitmap_size (pool->used_map);
+
+	while (order < PALLOC_ORDERS - 1) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+		if (buddy >= page_cnt || pool->pages[buddy].order != order)
+			break;
+		list_remove (&pool->pages[buddy].elem);
+		pool->pages[buddy].order = -1;
+		page_idx &= ~((size_t) 1 << order);
+		order++;
+	}
+	block_push (pool, page_idx, order);
+}
+
+/* Returns the PAGE_CNT pages at PAGE_IDX, which need not form a
+   single block, to POOL as the largest aligned blocks that fit.
+   POOL's lock must be held. */
+static void
+buddy_free_range (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	while (page_cnt > 0) {
+		int order = 0;
+
+		while (order < PALLOC_ORDERS - 1
+				&& (page_idx & ((size_t) 1 << order)) == 0
+				&& ((size_t) 2 << order) <= page_cnt)
+			order++;
+		buddy_free (pool, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL, a single page
+   through this CPU's page cache.  Returns the index of the first
+   page, or BITMAP_ERROR if POOL has no run that long. */
+static size_t
+pool_alloc (struct pool *pool, size_t page_cnt) {
+	int order = block_order (page_cnt);
+	size_t page_idx;
+	enum intr_level old_level;
+
+	if (page_cnt == 1)
+		return page_cache_get (pool);
+	if (page_cnt == 0 || order >= PALLOC_ORDERS)
+		return BITMAP_ERROR;
+
+	old_level = spinlock_acquire (&pool->lock);
+	page_idx = buddy_alloc (pool, order);
+	if (page_idx != BITMAP_ERROR) {
+		// 요청보다 큰 블록이면 남는 꼬리 페이지들은 돌려준다.
+		buddy_free_range (pool, page_idx + page_cnt,
+				((size_t) 1 << order) - page_cnt);
+		bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+	}
+	spinlock_release (&pool->lock, old_level);
+	return page_idx;
+}
+
+/* Returns the index of a page of POOL that is already filled with
+   zeros, or BITMAP_ERROR if there is none at the moment.  Asks
+   for a refill the next time the CPU is idle when POOL runs
+   low. */
+static size_t
+zeroed_get (struct pool *pool) {
+	enum intr_level old_level = spinlock_acquire (&pool->lock);
+	size_t page_idx = BITMAP_ERROR;
+
+	if (!list_empty (&pool->zeroed)) {
+		struct page_info *info = list_entry (list_pop_front (&pool->zeroed),
+				struct page_info, elem);
+		page_idx = info - pool->pages;
+		pool->zeroed_cnt--;
+		pool->zeroed_hits++;
+	} else
+		pool->zeroed_misses++;
+	if (pool->zeroed_cnt < ZERO_LOW)
+		pool->zero_wanted = true; // 깨우는 일은 유휴 스레드가 한다.
+	spinlock_release (&pool->lock, old_level);
+	return page_idx;
+}
+
+/* Gives all of POOL's zeroed pages back to it.  Returns true if
+   there were any. */
+static bool
+zeroed_reclaim (struct pool *pool) {
+	enum intr_level old_level = spinlock_acquire (&pool->lock);
+	bool reclaimed = !list_empty (&pool->zeroed);
+
+	while (!list_empty (&pool->zeroed)) {
+		struct page_info *info = list_entry (list_pop_front (&pool->zeroed),
+				struct page_info, elem);
+		size_t page_idx = info - pool->pages;
+
+		bitmap_reset (pool->used_map, page_idx);
+		buddy_free_range (pool, page_idx, 1);
+	}
+	pool->zeroed_cnt = 0;
+	spinlock_release (&pool->lock, old_level);
+	return reclaimed;
+}
+
+/* Clears pages of POOL until it has ZERO_TARGET zeroed pages, or
+   it runs out of free pages, and returns true.  Stops early and
+   returns false as soon as another thread is ready to run on this
+   CPU.  Pages come straight from the buddy free lists, so that
+   zeroing does not drain the per-CPU page caches. */
+static bool
+zeroed_fill (struct pool *pool) {
+	for (;;) {
+		enum intr_level old_level = spinlock_acquire (&pool->lock);
+		size_t page_idx = BITMAP_ERROR;
+
+		if (thread_ready_waiting ()) { // 다른 스레드가 기다리면 CPU를 바로 넘긴다.
+			spinlock_release (&pool->lock, old_level);
+			return false;
+		}
+		if (pool->zeroed_cnt < ZERO_TARGET)
+			page_idx = buddy_alloc (pool, 0);
+		if (page_idx == BITMAP_ERROR) {
+			pool->zero_wanted = false;
+			spinlock_release (&pool->lock, old_level);
+			return true;
+		}
+		bitmap_mark (pool->used_map, page_idx);
+		spinlock_release (&pool->lock, old_level);
+
+		memset (pool->base + PGSIZE * page_idx, 0, PGSIZE); // 락 없이 페이지를 비운다.
+
+		old_level = spinlock_acquire (&pool->lock);
+		list_push_back (&pool->zeroed, &pool->pages[page_idx].elem);
+		pool->zeroed_cnt++;
+		spinlock_release (&pool->lock, old_level);
+	}
+}
+
+/* The zeroing thread.  Sleeps until the idle thread wakes it,
+   refills both pools, and goes back to sleep when done or when
+   other threads want the CPU. */
+static void
+zero_thread (void *aux UNUSED) {
+	if (thread_mlfqs) // MLFQS에서도 가능한 한 낮은 우선순위로 둔다.
+		thread_set_nice (NICE_MAX);
+
+	for (;;) {
+		sema_down (&zero_sema);
+		if (zeroed_fill (&kernel_pool))
+			zeroed_fill (&user_pool);
+		zero_awake = false;
+	}
+}
+
+/* Takes a single page out of this CPU's cache of POOL, refilling
+   the cache from POOL first if it is empty.  Returns the page's
+   index, or BITMAP_ERROR if POOL has no free page left. */
+static size_t
+page_cache_get (struct pool *pool) {
+	uint8_t *page = magazine_get (&pool->caches);
+	size_t page_idx;
+
+	if (page == NULL)
+		return BITMAP_ERROR;
+	page_idx = (page - pool->base) / PGSIZE;
+	pool->pages[page_idx].cached = false;
+	return page_idx;
+}
+
+/* Puts the single page at PAGE_IDX, which must be in use, into
+   this CPU's cache of POOL. */
+static void
+page_cache_put (struct pool *pool, size_t page_idx) {
+	/* 캐시에 든 페이지도 used_map에는 사용 중으로 남아 있으므로,
+	   같은 페이지를 두 번 해제하면 cached 플래그로 잡아낸다. */
+	ASSERT (bitmap_test (pool->used_map, page_idx));
+	ASSERT (!pool->pages[page_idx].cached);
+
+	pool->pages[page_idx].cached = true;
+	magazine_put (&pool->caches, pool->base + PGSIZE * page_idx);
+}
+
+/* Takes up to CNT single pages of pool POOL_ for a per-CPU cache
+   off the buddy free lists and stores their addresses in PAGES.
+   Returns the number of pages taken.  Interrupts must be off. */
+static size_t
+page_cache_refill (void *pool_, void **pages, size_t cnt) {
+	struct pool *pool = pool_;
+	size_t taken = 0;
+
+	spinlock_acquire (&pool->lock);
+	while (taken < cnt) {
+		size_t idx = buddy_alloc (pool, 0);
+		if (idx == BITMAP_ERROR)
+			break;
+		bitmap_mark (pool->used_map, idx);
+		pool->pages[idx].cached = true;
+		pages[taken++] = pool->base + PGSIZE * idx;
+	}
+	spinlock_release (&pool->lock, INTR_OFF);
+	return taken;
+}
 
-	*bm_base += bm_pages;
+/* Gives the CNT cached pages in PAGES back to pool POOL_.
+   Interrupts must be off. */
+static void
+page_cache_drain (void *pool_, void **pages, size_t cnt) {
+	struct pool *pool = pool_;
+
+	spinlock_acquire (&pool->lock);
+	for (size_t i = 0; i < cnt; i++) {
+		size_t idx = ((uint8_t *) pages[i] - pool->base) / PGSIZE;
+
+		ASSERT (pool->pages[idx].cached);
+		pool->pages[idx].cached = false;
+		bitmap_reset (pool->used_map, idx);
+		buddy_free_range (pool, idx, 1);
+	}
+	spinlock_release (&pool->lock, INTR_OFF);
+}
+
+/* Marks the PAGE_CNT pages at PAGE_IDX in POOL, which must all be
+   in use, as free. */
+static void
+pool_release (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	enum intr_level old_level = spinlock_acquire (&pool->lock);
+
+	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
+	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	buddy_free_range (pool, page_idx, page_cnt);
+	spinlock_release (&pool->lock, old_level);
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -0,0 +1,163 @@
+#include "threads/profile.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/scratch.h"
+#include "threads/spinlock.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/*------------------------- [P1] Sampling Profiler --------------------------*/
+/* Pages of samples, and the samples that fit in them.  At 100
+   samples a second this is about half a minute; later samples
+   are counted but dropped. */
+#define PROFILE_PAGES 64
+#define PROFILE_SAMPLES (PROFILE_PAGES * PGSIZE / sizeof (struct profile_sample))
+
+/* Magic number and version at the start of a dump. */
+#define PROFILE_MAGIC 0x46525050        /* "PPRF". */
+#define PROFILE_VERSION 1
+
+/* Header of a dump.  The samples follow. */
+struct profile_header {
+	uint32_t magic;                     /* PROFILE_MAGIC. */
+	uint16_t version;                   /* PROFILE_VERSION. */
+	uint16_t sample_size;               /* sizeof (struct profile_sample). */
+	uint32_t count;                     /* # of samples dumped. */
+	uint32_t dropped;                   /* # of samples that did not fit. */
+	uint32_t freq;                      /* Samples per second. */
+};
+
+bool profile_enabled;
+
+static struct profile_sample *samples;
+static size_t sample_cnt;
+static size_t dropped_cnt;
+static struct spinlock profile_lock;
+
+static int walk_kernel (struct thread *, uint64_t fp, uint64_t *pcs, int max);
+static int walk_user (struct thread *, uint64_t fp, uint64_t *pcs, int max);
+
+/* Allocates the sample buffer, if profiling is enabled. */
+void
+profile_init (void) {
+	if (!profile_enabled)
+		return;
+
+	spinlock_init (&profile_lock);
+	samples = palloc_get_multiple (PAL_ZERO, PROFILE_PAGES);
+	if (samples == NULL) {
+		printf ("profile: out of memory, profiling disabled\n");
+		profile_enabled = false;
+	}
+}
+
+/* Records a sample of the thread interrupted with frame F.
+   Called by the timer interrupt handler. */
+void
+profile_sample (const struct intr_frame *f) {
+	struct thread *t = thread_current ();
+	struct profile_sample *s;
+	enum intr_level old_level;
+
+	ASSERT (intr_context ());
+
+	if (!profile_enabled)
+		return;
+
+	old_level = spinlock_acquire (&profile_lock);
+	if (sample_cnt < PROFILE_SAMPLES)
+		s = &samples[sample_cnt++];
+	else {
+		s = NULL;
+		dropped_cnt++;
+	}
+	spinlock_release (&profile_lock, old_level);
+	if (s == NULL)
+		return;
+
+	s->tid = t->tid;
+	s->cpu = this_cpu ()->id;
+	s->user = (f->cs & 3) == 3;
+	strlcpy (s->name, t->name, sizeof s->name);
+	s->pcs[0] = f->rip;
+	s->depth = 1 + (s->user
+			? walk_user (t, f->R.rbp, s->pcs + 1, PROFILE_DEPTH - 1)
+			: walk_kernel (t, f->R.rbp, s->pcs + 1, PROFILE_DEPTH - 1));
+}
+
+/* Follows the frame pointer chain from FP on T's kernel stack,
+   storing up to MAX return addresses into PCS.  Returns the
+   number stored.  Stops at the first frame pointer that does not
+   point into T's stack page. */
+static int
+walk_kernel (struct thread *t, uint64_t fp, uint64_t *pcs, int max) {
+	uint64_t lo = (uint64_t) t + sizeof *t;
+	uint64_t hi = (uint64_t) t + PGSIZE;
+	int depth = 0;
+
+	while (depth < max && fp >= lo && fp + 16 <= hi && fp % 8 == 0) {
+		uint64_t *frame = (uint64_t *) fp;
+
+		pcs[depth++] = frame[1];
+		if (frame[0] <= fp) // 스택은 위로 풀려야 한다.
+			break;
+		fp = frame[0];
+	}
+	return depth;
+}
+
+/* Like walk_kernel(), but for T's user stack.  Reads the frames
+   through T's page table, so a frame on a page that is not
+   present just ends the walk instead of faulting. */
+static int
+walk_user (struct thread *t, uint64_t fp, uint64_t *pcs, int max) {
+	int depth = 0;
+
+	if (t->pml4 == NULL)
+		return 0;
+	while (depth < max && fp % 8 == 0 && is_user_vaddr ((void *) (fp + 15))) {
+		uint64_t *frame = pml4_get_page (t->pml4, (void *) fp);
+
+		if (frame == NULL || pg_ofs ((void *) fp) > PGSIZE - 16) // 프레임이 페이지 경계에 걸치면 멈춘다.
+			break;
+		pcs[depth++] = frame[1];
+		if (frame[0] <= fp)
+			break;
+		fp = frame[0];
+	}
+	return depth;
+}
+
+/* The "profdump" action: writes the samples to the scratch disk.
+   Stops profiling first. */
+void
+profile_dump (char **argv UNUSED) {
+	struct profile_header hdr;
+	struct scratch_writer w;
+
+	if (!profile_enabled) {
+		printf ("profdump: profiling is off (use -profile)\n");
+		return;
+	}
+	profile_enabled = false;
+
+	memset (&hdr, 0, sizeof hdr);
+	hdr.magic = PROFILE_MAGIC;
+	hdr.version = PROFILE_VERSION;
+	hdr.sample_size = sizeof (struct profile_sample);
+	hdr.count = sample_cnt;
+	hdr.dropped = dropped_cnt;
+	hdr.freq = TIMER_FREQ;
+	printf ("Dumping %zu profile samples to the scratch disk...\n", sample_cnt);
+
+	scratch_begin (&w, sizeof hdr + sample_cnt * sizeof *samples);
+	scratch_write (&w, &hdr, sizeof hdr);
+	scratch_write (&w, samples, sample_cnt * sizeof *samples);
+	scratch_end (&w);
+}
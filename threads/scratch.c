@@ -0,0 +1,62 @@
+#include "threads/scratch.h"
+#include <debug.h>
+#include <string.h>
+#include "threads/palloc.h"
+
+/* First sector of the next dump. */
+static disk_sector_t next_sector;
+
+/* Starts a dump of SIZE bytes into W. */
+void
+scratch_begin (struct scratch_writer *w, size_t size) {
+	w->disk = disk_get (1, 0);
+	if (w->disk == NULL)
+		PANIC ("couldn't open target disk (hdc or hd1:0)");
+	w->sector = next_sector;
+	w->buf = palloc_get_page (PAL_ASSERT);
+	w->ofs = 0;
+
+	memset (w->buf, 0, DISK_SECTOR_SIZE);
+	memcpy (w->buf, "GET", 4);
+	((int32_t *) w->buf)[1] = size;
+	if (w->sector >= disk_size (w->disk))
+		PANIC ("out of space on scratch disk");
+	disk_write (w->disk, w->sector++, w->buf);
+}
+
+/* Appends SIZE bytes from DATA to W, writing out every sector
+   that fills up. */
+void
+scratch_write (struct scratch_writer *w, const void *data, size_t size) {
+	const uint8_t *src = data;
+
+	while (size > 0) {
+		size_t chunk = DISK_SECTOR_SIZE - w->ofs;
+		if (chunk > size)
+			chunk = size;
+		memcpy (w->buf + w->ofs, src, chunk);
+		src += chunk;
+		size -= chunk;
+		w->ofs += chunk;
+		if (w->ofs == DISK_SECTOR_SIZE) {
+			if (w->sector >= disk_size (w->disk))
+				PANIC ("out of space on scratch disk");
+			disk_write (w->disk, w->sector++, w->buf);
+			w->ofs = 0;
+		}
+	}
+}
+
+/* Writes out the last, partial sector of W and finishes the
+   dump.  The next dump goes right after it. */
+void
+scratch_end (struct scratch_writer *w) {
+	if (w->ofs > 0) {
+		memset (w->buf + w->ofs, 0, DISK_SECTOR_SIZE - w->ofs);
+		if (w->sector >= disk_size (w->disk))
+			PANIC ("out of space on scratch disk");
+		disk_write (w->disk, w->sector++, w->buf);
+	}
+	next_sector = w->sector;
+	palloc_free_page (w->buf);
+}
@@ -0,0 +1,340 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/magazine.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/spinlock.h"
+#include "threads/vaddr.h"
+
+/*------------------------- [P3] Slab Allocator --------------------------*/
+/* A slab is one page.  It starts with a struct slab, followed by
+   one 16-bit index per object that links the slab's free objects
+   together, followed by the objects themselves.  Keeping the free
+   list out of the objects is what lets a free object keep its
+   constructed state.
+
+   A cache keeps its slabs on three lists: slabs with both free
+   and used objects, slabs with no free objects, and slabs with no
+   used objects.  Only one empty slab is kept; the pages of other
+   empty slabs go back to the page allocator.
+
+   In front of the slabs, each CPU has a small magazine of free
+   objects per cache (see threads/magazine.h), refilled from and
+   drained to the slabs MAGAZINE_BATCH objects at a time under the
+   cache's lock. */
+
+/* Maximum number of caches. */
+#define KMEM_CACHE_MAX 16
+
+/* Objects are aligned to this many bytes. */
+#define SLOT_ALIGN 8
+
+/* Magic number for detecting slabs.  It sits where struct arena in
+   malloc.c keeps ARENA_MAGIC, so free() can tell the two apart. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* End of a slab's free list. */
+#define SLAB_END UINT16_MAX
+
+/* Slab header. */
+struct slab {
+	unsigned magic;             /* Always set to SLAB_MAGIC. */
+	struct kmem_cache *cache;   /* Owning cache. */
+	struct list_elem elem;      /* Element in one of the cache's lists. */
+	size_t in_use;              /* Objects not on the free list. */
+	uint16_t free;              /* First free object, or SLAB_END. */
+	uint16_t next[];            /* Free object after each free object. */
+};
+
+/* Object cache. */
+struct kmem_cache {
+	const char *name;           /* For the -kmemstat report. */
+	size_t size;                /* Object size asked for. */
+	size_t slot_size;           /* SIZE rounded up to SLOT_ALIGN. */
+	size_t obj_cnt;             /* Objects per slab. */
+	size_t obj_ofs;             /* Offset of the first object in a slab. */
+	kmem_ctor *ctor;            /* Constructor, or null. */
+
+	struct spinlock lock;       /* Protects the members below. */
+	struct list partial;        /* Slabs with free and used objects. */
+	struct list full;           /* Slabs without free objects. */
+	struct list empty;          /* Slabs without used objects (at most 1). */
+	size_t slab_cnt;            /* # of slabs. */
+	size_t peak_slab_cnt;       /* Largest SLAB_CNT so far. */
+
+	struct magazine_rack mags;  /* Per-CPU magazines. */
+};
+
+bool kmemstat_enabled;
+
+static struct kmem_cache caches[KMEM_CACHE_MAX];
+static int cache_cnt;
+static struct spinlock caches_lock;
+
+static struct slab *slab_create (struct kmem_cache *);
+static void slab_put (struct kmem_cache *, void *obj);
+static magazine_refill_func cache_refill;
+static magazine_drain_func cache_drain;
+
+/* Returns the slab that OBJ is in. */
+static struct slab *
+obj_to_slab (const void *obj) {
+	struct slab *s = pg_round_down (obj);
+
+	ASSERT (s->magic == SLAB_MAGIC);
+	return s;
+}
+
+/* Returns the IDX'th object in slab S of cache C. */
+static void *
+slab_obj (struct kmem_cache *c, struct slab *s, size_t idx) {
+	return (uint8_t *) s + c->obj_ofs + idx * c->slot_size;
+}
+
+/* Creates and returns a cache of SIZE-byte objects called NAME.
+   If CTOR is non-null, it initializes each object once, when its
+   slab is created.  Panics if there are too many caches or SIZE
+   does not fit in a slab. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, kmem_ctor *ctor) {
+	static bool initialized;
+	struct kmem_cache *c;
+	enum intr_level old_level;
+	size_t n;
+
+	ASSERT (size > 0);
+
+	old_level = intr_disable ();
+	if (!initialized) {
+		spinlock_init (&caches_lock);
+		initialized = true;
+	}
+	spinlock_acquire (&caches_lock);
+	if (cache_cnt == KMEM_CACHE_MAX)
+		PANIC ("kmem_cache_create: too many caches (%s)", name);
+	c = &caches[cache_cnt++];
+	spinlock_release (&caches_lock, old_level);
+
+	memset (c, 0, sizeof *c);
+	c->name = name;
+	c->size = size;
+	c->slot_size = ROUND_UP (size, SLOT_ALIGN);
+	c->ctor = ctor;
+
+	/* As many objects as fit together with their free list links. */
+	for (n = (PGSIZE - sizeof (struct slab)) / (c->slot_size + sizeof (uint16_t));
+			n > 0; n--) {
+		c->obj_ofs = ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t),
+				SLOT_ALIGN);
+		if (c->obj_ofs + n * c->slot_size <= PGSIZE)
+			break;
+	}
+	if (n == 0)
+		PANIC ("kmem_cache_create: %zu-byte objects do not fit a slab (%s)",
+				size, name);
+	c->obj_cnt = n;
+
+	spinlock_init (&c->lock);
+	list_init (&c->partial);
+	list_init (&c->full);
+	list_init (&c->empty);
+	magazine_rack_init (&c->mags, MAGAZINE_SIZE, MAGAZINE_BATCH,
+			cache_refill, cache_drain, c);
+	return c;
+}
+
+/* Allocates and returns an object from cache C, or a null
+   pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	return magazine_get (&c->mags);
+}
+
+/* Like kmem_cache_alloc(), but fills the object with zeros.  C
+   must not have a constructor. */
+void *
+kmem_cache_zalloc (struct kmem_cache *c) {
+	void *obj;
+
+	ASSERT (c->ctor == NULL);
+
+	obj = kmem_cache_alloc (c);
+	if (obj != NULL)
+		memset (obj, 0, c->size);
+	return obj;
+}
+
+/* Gives OBJ, which must have been allocated from cache C, back to
+   C.  Does nothing if OBJ is null. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) {
+	if (obj == NULL)
+		return;
+	ASSERT (obj_to_slab (obj)->cache == c);
+
+#ifndef NDEBUG
+	/* Clear the object to help detect use-after-free bugs, unless
+	   it has to keep its constructed state. */
+	if (c->ctor == NULL)
+		memset (obj, 0xcc, c->size);
+#endif
+
+	magazine_put (&c->mags, obj);
+}
+
+/* Returns true if P was allocated from an object cache. */
+bool
+kmem_owns (const void *p) {
+	return p != NULL && ((struct slab *) pg_round_down (p))->magic == SLAB_MAGIC;
+}
+
+/* Returns the size of the objects of the cache that P, which must
+   be an object from a cache, came from. */
+size_t
+kmem_size (const void *p) {
+	return obj_to_slab (p)->cache->size;
+}
+
+/* Gives P, which must be an object from a cache, back to its
+   cache. */
+void
+kmem_free (void *p) {
+	kmem_cache_free (obj_to_slab (p)->cache, p);
+}
+
+/* Takes up to CNT objects of cache C_ for OBJS off the slabs,
+   creating a slab if none has free objects.  Returns the number
+   of objects taken.  Interrupts must be off. */
+static size_t
+cache_refill (void *c_, void **objs, size_t cnt) {
+	struct kmem_cache *c = c_;
+	size_t taken = 0;
+
+	spinlock_acquire (&c->lock);
+	while (taken < cnt) {
+		struct slab *s;
+		uint16_t idx;
+
+		if (!list_empty (&c->partial))
+			s = list_entry (list_front (&c->partial), struct slab, elem);
+		else if (!list_empty (&c->empty)) {
+			s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+			list_push_front (&c->partial, &s->elem);
+		} else {
+			spinlock_release (&c->lock, INTR_OFF); // 생성자는 락 없이 돌린다.
+			s = slab_create (c);
+			spinlock_acquire (&c->lock);
+			if (s == NULL)
+				break;
+			list_push_front (&c->partial, &s->elem);
+			if (++c->slab_cnt > c->peak_slab_cnt)
+				c->peak_slab_cnt = c->slab_cnt;
+		}
+
+		idx = s->free;
+		s->free = s->next[idx];
+		objs[taken++] = slab_obj (c, s, idx);
+		if (++s->in_use == c->obj_cnt) {
+			list_remove (&s->elem);
+			list_push_front (&c->full, &s->elem);
+		}
+	}
+	spinlock_release (&c->lock, INTR_OFF);
+	return taken;
+}
+
+/* Gives the CNT objects in OBJS back to their slabs in cache C_.
+   Interrupts must be off. */
+static void
+cache_drain (void *c_, void **objs, size_t cnt) {
+	struct kmem_cache *c = c_;
+
+	spinlock_acquire (&c->lock);
+	for (size_t i = 0; i < cnt; i++)
+		slab_put (c, objs[i]);
+	spinlock_release (&c->lock, INTR_OFF);
+}
+
+/* Allocates a slab for cache C and constructs its objects.
+   Returns the slab, or a null pointer if no page is available. */
+static struct slab *
+slab_create (struct kmem_cache *c) {
+	struct slab *s = palloc_get_page (0);
+	size_t i;
+
+	if (s == NULL)
+		return NULL;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->in_use = 0;
+	s->free = 0;
+	for (i = 0; i < c->obj_cnt; i++) {
+		s->next[i] = i + 1 < c->obj_cnt ? i + 1 : SLAB_END;
+		if (c->ctor != NULL)
+			c->ctor (slab_obj (c, s, i));
+	}
+	return s;
+}
+
+/* Puts OBJ back on its slab's free list.  C's lock must be
+   held. */
+static void
+slab_put (struct kmem_cache *c, void *obj) {
+	struct slab *s = obj_to_slab (obj);
+	size_t ofs = (uint8_t *) obj - (uint8_t *) slab_obj (c, s, 0);
+	uint16_t idx = ofs / c->slot_size;
+
+	ASSERT (s->cache == c);
+	ASSERT (ofs % c->slot_size == 0 && idx < c->obj_cnt);
+	ASSERT (s->in_use > 0);
+
+	s->next[idx] = s->free;
+	s->free = idx;
+	if (s->in_use-- == c->obj_cnt) { // 가득 찬 슬랩에 빈 자리가 생겼다.
+		list_remove (&s->elem);
+		list_push_front (&c->partial, &s->elem);
+	}
+	if (s->in_use == 0) {
+		list_remove (&s->elem);
+		if (list_empty (&c->empty))
+			list_push_front (&c->empty, &s->elem);
+		else { // 빈 슬랩은 하나만 남기고 페이지를 돌려준다.
+			s->magic = 0;
+			palloc_free_page (s);
+			c->slab_cnt--;
+		}
+	}
+}
+
+/* Prints, for each cache, how much memory an object takes in a
+   slab compared to what malloc() would use for it. */
+void
+kmem_print_stats (void) {
+	if (!kmemstat_enabled)
+		return;
+
+	printf ("Slab caches: %d caches\n", cache_cnt);
+	printf ("  %-16s %5s %5s %5s %8s %13s %9s %9s\n", "cache", "size",
+			"slot", "/slab", "live", "slabs (peak)", "bytes/obj", "malloc");
+	for (int i = 0; i < cache_cnt; i++) {
+		struct kmem_cache *c = &caches[i];
+		struct magazine total;
+		long long live;
+
+		/* 리필된 직후의 할당도 하나씩 나가므로 hits + refills가 할당 수다. */
+		magazine_rack_stats (&c->mags, &total);
+		live = total.hits + total.refills - total.puts;
+		printf ("  %-16s %5zu %5zu %5zu %8lld %6zu (%4zu) %9zu %9zu\n",
+				c->name, c->size, c->slot_size, c->obj_cnt, live,
+				c->slab_cnt, c->peak_slab_cnt, PGSIZE / c->obj_cnt,
+				malloc_footprint (c->size));
+	}
+}
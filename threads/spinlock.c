@@ -0,0 +1,65 @@
+#include "threads/spinlock.h"
+#include <debug.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+
+/*------------------------- [P1] SMP --------------------------*/
+/* Atomically stores NEW in *ADDR and returns the old value.
+   `xchg' with a memory operand is implicitly locked. */
+static inline unsigned
+atomic_xchg (volatile unsigned *addr, unsigned new) {
+	asm volatile ("xchgl %0, %1"
+			: "+r" (new), "+m" (*addr)
+			:
+			: "memory");
+	return new;
+}
+
+/* Initializes spin lock LOCK as released. */
+void
+spinlock_init (struct spinlock *lock) {
+	ASSERT (lock != NULL);
+
+	lock->locked = 0;
+	lock->cpu = NULL;
+}
+
+/* Turns interrupts off, then spins until LOCK is acquired.
+   Returns the interrupt level from before the call.  LOCK must
+   not already be held by this CPU. */
+enum intr_level
+spinlock_acquire (struct spinlock *lock) {
+	enum intr_level old_level;
+
+	ASSERT (lock != NULL);
+
+	old_level = intr_disable ();
+	ASSERT (!spinlock_held_by_current_cpu (lock));
+
+	while (atomic_xchg (&lock->locked, 1) != 0)
+		while (lock->locked)
+			asm volatile ("pause" : : : "memory"); // 다른 CPU가 놓을 때까지 읽기만 하면서 기다린다.
+	lock->cpu = this_cpu ();
+	return old_level;
+}
+
+/* Releases LOCK, which must be held by this CPU, and sets the
+   interrupt level to OLD_LEVEL. */
+void
+spinlock_release (struct spinlock *lock, enum intr_level old_level) {
+	ASSERT (lock != NULL);
+	ASSERT (spinlock_held_by_current_cpu (lock));
+
+	lock->cpu = NULL;
+	atomic_xchg (&lock->locked, 0);
+	intr_set_level (old_level);
+}
+
+/* Returns true if this CPU holds LOCK.  Interrupts must be off,
+   otherwise the answer could be stale by the time it is used. */
+bool
+spinlock_held_by_current_cpu (const struct spinlock *lock) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	return lock->locked && lock->cpu == this_cpu ();
+}
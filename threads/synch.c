@@ -31,13 +31,34 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "devices/timer.h"
 
 /*------------------------- [P1] Priority Scheduling --------------------------*/
-void donate_priority(void);
-void remove_with_lock(struct lock *);
+/* Protects priority donation: every lock's waiters heap, a lock's
+   holder while it has waiters, every thread's held_locks heap and
+   wait_on_lock, and the clearing of wait_on_sema.  It nests inside
+   a lock's spin lock and outside semaphore and run queue spin
+   locks.  Being static, it starts out zeroed, that is, released. */
+static struct spinlock pi_lock;
+
 void refresh_priority(void);
-static bool cmp_d_priority (const struct list_elem *, const struct list_elem *, void *aux);
+static bool cmp_wait_priority (const struct heap_elem *, const struct heap_elem *, void *aux);
 static bool cmp_sem_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
+static int lock_waiter_priority (struct lock *);
+static void lock_take (struct lock *);
+static void sema_requeue (struct thread *);
+static void donate_to (struct thread *, int priority);
+
+/*------------------------- [P4] Reader-Writer Lock --------------------------*/
+static void rwlock_wait (struct rwlock *, bool write, enum intr_level);
+static int rwlock_grant (struct rwlock *);
+static int rwlock_grant_readers (struct rwlock *);
+static void rwlock_finish_release (struct rwlock *, int woken, enum intr_level);
+static void rwlock_donate (struct rwlock *, int priority);
+static int rwlock_waiter_priority (struct rwlock *);
+static void rwlock_hold_add (struct rwlock *, struct thread *);
+static void rwlock_hold_remove (struct rwlock *, struct thread *);
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -47,13 +68,18 @@ static bool cmp_sem_priority (const struct list_elem *a, const struct list_elem
    decrement it.
 
    - up or "V": increment the value (and wake up one waiting
-   thread, if any). */
+   thread, if any).
+
+   NAME identifies the semaphore in the -lockstat report; a null
+   NAME keeps it out of the report. */
 void
-sema_init (struct semaphore *sema, unsigned value) {
+sema_init_named (struct semaphore *sema, unsigned value, const char *name) {
 	ASSERT (sema != NULL);
 
 	sema->value = value;
-	list_init (&sema->waiters);
+	heap_init (&sema->waiters, cmp_wait_priority, NULL);
+	spinlock_init (&sema->spin);
+	sema->stat = lockstat_register (name, true);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -66,19 +92,34 @@ sema_init (struct semaphore *sema, unsigned value) {
    sema_down function. */
 void
 sema_down (struct semaphore *sema) {
+	struct thread *curr = thread_current ();
 	enum intr_level old_level;
 
 	ASSERT (sema != NULL);
 	ASSERT (!intr_context ());
 
-	old_level = intr_disable ();
+	old_level = spinlock_acquire (&sema->spin);
+	bool contended = sema->value == 0;
+	int64_t start = sema->stat != NULL && contended ? timer_ticks () : 0;
 	while (sema->value == 0) { // 공유 자원을 이용할 수 없는 상태
-		list_insert_ordered(&sema->waiters, &thread_current ()->elem, cmp_priority, NULL);
-		// list_push_back (&sema->waiters, &thread_current ()->elem);
+		curr->wait_on_sema = sema; // 기다리는 동안 받은 donation은 sema_requeue()가 반영한다.
+		heap_push (&sema->waiters, &curr->wait_elem);
+		spinlock_release (&sema->spin, INTR_OFF); // block 될 때까지 인터럽트는 꺼둔다.
 		thread_block ();
+		spinlock_acquire (&sema->spin);
 	}
 	sema->value--;
+	spinlock_release (&sema->spin, INTR_OFF);
+
+	if (contended) { // donation 중인 스레드가 SEMA를 다 쓸 때까지 기다렸다가 지운다.
+		spinlock_acquire (&pi_lock);
+		curr->wait_on_sema = NULL;
+		spinlock_release (&pi_lock, INTR_OFF);
+	}
 	intr_set_level (old_level);
+
+	if (sema->stat != NULL)
+		lockstat_acquired (sema->stat, contended, contended ? timer_ticks () - start : 0);
 }
 
 /* Down or "P" operation on a semaphore, but only if the
@@ -93,7 +134,7 @@ sema_try_down (struct semaphore *sema) {
 
 	ASSERT (sema != NULL);
 
-	old_level = intr_disable ();
+	old_level = spinlock_acquire (&sema->spin);
 	if (sema->value > 0)
 	{
 		sema->value--;
@@ -101,7 +142,7 @@ sema_try_down (struct semaphore *sema) {
 	}
 	else
 		success = false;
-	intr_set_level (old_level);
+	spinlock_release (&sema->spin, old_level);
 
 	return success;
 }
@@ -112,19 +153,21 @@ sema_try_down (struct semaphore *sema) {
    This function may be called from an interrupt handler. */
 void
 sema_up (struct semaphore *sema) {
+	struct thread *new_lockholder = NULL;
 	enum intr_level old_level;
 
 	ASSERT (sema != NULL);
 
-	old_level = intr_disable ();
+	old_level = spinlock_acquire (&sema->spin);
 	sema->value++;
-	if (!list_empty (&sema->waiters)){
-		list_sort(&sema->waiters, cmp_priority, NULL); // waiter_list 정렬
-		struct thread *new_lockholder = list_entry(list_pop_front (&sema->waiters), struct thread, elem);
+	if (!heap_empty (&sema->waiters)){ // 우선순위가 가장 높은 waiter를 꺼낸다.
+		new_lockholder = heap_entry (heap_pop (&sema->waiters), struct thread, wait_elem);
 		thread_unblock (new_lockholder); // 세마포어를 해제하고 레디 상태로 만들어준다.
-		if (thread_get_priority() < new_lockholder->priority )
-			thread_yield();
 	}
+	spinlock_release (&sema->spin, INTR_OFF); // 양보하기 전에 스핀락을 놓는다.
+
+	if (new_lockholder != NULL && thread_get_priority() < new_lockholder->priority )
+		thread_yield();
 	intr_set_level (old_level);
 }
 
@@ -179,11 +222,25 @@ sema_test_helper (void *sema_) {
    onerous, it's a good sign that a semaphore should be used,
    instead of a lock. */
 void
-lock_init (struct lock *lock) {
+lock_init_named (struct lock *lock, const char *name) {
 	ASSERT (lock != NULL);
 
 	lock->holder = NULL;
-	sema_init (&lock->semaphore, 1);
+	spinlock_init (&lock->spin);
+	heap_init (&lock->waiters, cmp_wait_priority, NULL);
+	lock->barging = false;
+	lock->stat = lockstat_register (name, false);
+	lock->acquired_at = 0;
+}
+
+/* Lets running threads take LOCK ahead of a waiter that
+   lock_release() has woken up but that has not run yet, instead of
+   handing LOCK to that waiter directly. */
+void
+lock_allow_barging (struct lock *lock) {
+	ASSERT (lock != NULL);
+
+	lock->barging = true;
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -196,18 +253,44 @@ lock_init (struct lock *lock) {
    we need to sleep. */
 void
 lock_acquire (struct lock *lock) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (!lock_held_by_current_thread (lock));
 
-	if (lock->holder != NULL) { // 해당 lock의 holder가 존재한다면
-		thread_current()->wait_on_lock = lock;// 해당 락을 wait_on_lock에 추가한다.
-		list_insert_ordered(&lock->holder->donations, &thread_current()->d_elem, cmp_d_priority, NULL);
-		donate_priority();
+	old_level = spinlock_acquire (&lock->spin);
+	bool contended = lock->holder != NULL;
+	int64_t start = lock->stat != NULL && contended ? timer_ticks () : 0;
+
+	if (contended && lock->holder != curr)
+		trace_event (TRACE_LOCK_CONTENDED, (uintptr_t) lock, lock->holder->tid);
+
+	while (lock->holder != NULL && lock->holder != curr) { // 해당 lock의 holder가 존재한다면
+		spinlock_acquire (&pi_lock);
+		curr->wait_on_lock = lock; // 해당 락을 wait_on_lock에 추가한다.
+		heap_push (&lock->waiters, &curr->wait_elem);
+		if (heap_size (&lock->waiters) == 1) // 첫 waiter면 holder의 held_locks에 넣고, 아니면 위치만 고친다.
+			heap_push (&lock->holder->held_locks, &lock->held_elem);
+		else
+			heap_update (&lock->holder->held_locks, &lock->held_elem);
+		if (!thread_mlfqs) // MLFQS에서는 donation 하지 않는다.
+			donate_to (lock->holder, curr->priority);
+		spinlock_release (&pi_lock, INTR_OFF);
+
+		spinlock_release (&lock->spin, INTR_OFF); // block 될 때까지 인터럽트는 꺼둔다.
+		thread_block (); // lock_release()가 락을 넘겨준 뒤 (barging이면 비워둔 뒤) 깨운다.
+		spinlock_acquire (&lock->spin);
+	}
+	if (lock->holder == NULL)
+		lock_take (lock);
+	spinlock_release (&lock->spin, old_level);
+
+	if (lock->stat != NULL) {
+		lock->acquired_at = timer_ticks ();
+		lockstat_acquired (lock->stat, contended, contended ? lock->acquired_at - start : 0);
 	}
-	sema_down (&lock->semaphore);
-	thread_current()->wait_on_lock = NULL; // 해당 스레드의 wait_on_lock을 NULL로 만든다.
-	lock->holder = thread_current();
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -218,33 +301,78 @@ lock_acquire (struct lock *lock) {
    interrupt handler. */
 bool
 lock_try_acquire (struct lock *lock) {
+	enum intr_level old_level;
 	bool success;
 
 	ASSERT (lock != NULL);
 	ASSERT (!lock_held_by_current_thread (lock));
 
-	success = sema_try_down (&lock->semaphore);
+	old_level = spinlock_acquire (&lock->spin);
+	success = lock->holder == NULL;
 	if (success)
-		lock->holder = thread_current ();
+		lock_take (lock);
+	spinlock_release (&lock->spin, old_level);
+
+	if (success && lock->stat != NULL) {
+		lock->acquired_at = timer_ticks ();
+		lockstat_acquired (lock->stat, false, 0);
+	}
 	return success;
 }
 
 /* Releases LOCK, which must be owned by the current thread.
    This is lock_release function.
 
+   If a waiter with a higher priority than ours gets LOCK, we
+   yield to it, but only once interrupts are on: a caller that
+   releases LOCK with interrupts off keeps the CPU until it turns
+   them back on.
+
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to release a lock within an interrupt
    handler. */
 void
 lock_release (struct lock *lock) {
+	struct thread *next = NULL;
+	enum intr_level old_level;
+
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
-	remove_with_lock(lock);
-	refresh_priority();
-
-	lock->holder = NULL;
-	sema_up (&lock->semaphore);
+	if (lock->stat != NULL)
+		lockstat_released (lock->stat, timer_ticks () - lock->acquired_at);
+
+	old_level = spinlock_acquire (&lock->spin);
+	if (!heap_empty (&lock->waiters)) { // 우선순위가 가장 높은 waiter에게 락을 넘긴다.
+		spinlock_acquire (&pi_lock);
+		heap_remove (&thread_current ()->held_locks, &lock->held_elem); // 이 락으로 받은 donation을 내려놓는다.
+		next = heap_entry (heap_pop (&lock->waiters), struct thread, wait_elem);
+		next->wait_on_lock = NULL;
+		if (lock->barging)
+			lock->holder = NULL; // 깨어난 뒤 다시 경쟁한다.
+		else {
+			lock->holder = next; // 깨어나면 바로 락을 가진 상태다.
+			if (!heap_empty (&lock->waiters)) { // 남은 waiter들은 이제 NEXT에게 기부한다.
+				heap_push (&next->held_locks, &lock->held_elem);
+				if (!thread_mlfqs)
+					donate_to (next, lock_waiter_priority (lock));
+			}
+		}
+		spinlock_release (&pi_lock, INTR_OFF);
+		thread_unblock (next);
+	} else
+		lock->holder = NULL;
+	spinlock_release (&lock->spin, INTR_OFF); // 양보하기 전에 스핀락을 놓는다.
+
+	if (!thread_mlfqs) // MLFQS에서는 donation이 없으므로 우선순위를 되돌릴 필요가 없다.
+		refresh_priority ();
+	if (next != NULL && thread_get_priority () < next->priority) {
+		if (old_level == INTR_OFF) // 호출자의 임계 구역이 끝나 인터럽트가 켜질 때 양보한다.
+			thread_defer_yield ();
+		else
+			thread_yield ();
+	}
+	intr_set_level (old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -257,80 +385,134 @@ lock_held_by_current_thread (const struct lock *lock) {
 	return lock->holder == thread_current ();
 }
 
+/* Makes the current thread the holder of LOCK, which must be
+   free.  If threads are already waiting for LOCK, it goes into the
+   current thread's held_locks and their priority is donated.
+   LOCK's spin lock must be held. */
+static void
+lock_take (struct lock *lock) {
+	struct thread *curr = thread_current ();
+
+	ASSERT (spinlock_held_by_current_cpu (&lock->spin));
+	ASSERT (lock->holder == NULL);
+
+	if (heap_empty (&lock->waiters)) { // waiters는 lock->spin과 pi_lock을 모두 잡아야 바뀐다.
+		lock->holder = curr;
+		return;
+	}
+
+	// 깨어난 스레드보다 먼저 락을 잡았거나, 깨어난 스레드 뒤에 아직 waiter가 남아있다.
+	spinlock_acquire (&pi_lock);
+	lock->holder = curr;
+	heap_push (&curr->held_locks, &lock->held_elem);
+	if (!thread_mlfqs && curr->priority < lock_waiter_priority (lock))
+		curr->priority = lock_waiter_priority (lock);
+	spinlock_release (&pi_lock, INTR_OFF);
+}
+
 
 /*------------------------- [P1] Priority Scheduling --------------------------*/
-// priority donation을 수행하는 함수
-// nested donation 고려
-void 
-donate_priority(void) {
-	ASSERT(thread_current()->wait_on_lock != NULL);
-	struct thread *curr_lock_holder = thread_current()->wait_on_lock->holder; // 현재 내가 기다리는 락을 소유하고 있는 스레드
-	int nested_depth = 8;
-	
+// 스레드 T에 PRIORITY를 기부하고, T가 또 다른 락을 기다리고 있으면 그 홀더에게도 기부한다. (nested donation)
+// 우선순위가 더 이상 오르지 않는 곳에서 멈추므로 깊이 제한은 필요 없다. pi_lock을 잡고 호출해야 한다.
+static void
+donate_to (struct thread *t, int priority) {
+	ASSERT (spinlock_held_by_current_cpu (&pi_lock));
+
 	// 만약 내 우선 순위가 lock이 걸린 스레드보다 높다면 우선순위 기부
-	while (thread_get_priority() > curr_lock_holder->priority){
-		if (nested_depth-- <= 0) break; // nested_depth 확인
-		curr_lock_holder->priority = thread_get_priority(); // 내 우선 순위 기부
-		
-		// 홀더가 또 다른 락을 기다리고 있을 때 반복문 다시 순회
-		if (curr_lock_holder->wait_on_lock != NULL)
-			curr_lock_holder = curr_lock_holder->wait_on_lock->holder;
-		else
-			break;
+	while (t != NULL && t->priority < priority) {
+		struct lock *lock = t->wait_on_lock;
+
+		thread_change_priority (t, priority); // 내 우선 순위 기부 (ready 상태면 큐도 옮긴다)
+		if (t->wait_on_sema != NULL)
+			sema_requeue (t);
+		else if (t->wait_on_rwlock != NULL) {
+			rwlock_donate (t->wait_on_rwlock, priority);
+			return;
+		}
+		if (lock == NULL)
+			return;
+
+		// 홀더가 또 다른 락을 기다리고 있을 때: 그 락의 waiters와 그 홀더의 held_locks에서 자리를 고친다.
+		heap_update (&lock->waiters, &t->wait_elem);
+		t = lock->holder;
+		if (t != NULL)
+			heap_update (&t->held_locks, &lock->held_elem);
 	}
 }
 
-// lock을 해제했을 때 donations에서 해당 스레드를 삭제한다.
-void 
-remove_with_lock(struct lock *lock) {
-	struct list_elem *curr = list_begin(&thread_current()->donations);
-	struct thread *curr_thread;
+// 세마포어에서 기다리는 스레드 T의 우선순위가 바뀌었을 때 waiters 힙에서 자리를 고친다.
+// pi_lock을 잡고 있는 동안에는 T가 sema_down()을 빠져나가지 못하므로 세마포어가 사라지지 않는다.
+static void
+sema_requeue (struct thread *t) {
+	struct semaphore *sema = t->wait_on_sema;
 
-	while (curr != list_end(&thread_current()->donations)){ // 전체 순회
-		curr_thread = list_entry(curr, struct thread, d_elem);
-		if (curr_thread -> wait_on_lock == lock)
-			curr = list_remove(curr); // donations에서 해당 락을 기다리고 있던 스레드 제거
-		else
-			curr = curr -> next;
-	}
+	ASSERT (spinlock_held_by_current_cpu (&pi_lock));
+
+	spinlock_acquire (&sema->spin);
+	if (heap_contains (&sema->waiters, &t->wait_elem)) // 이미 sema_up()이 꺼냈을 수 있다.
+		heap_update (&sema->waiters, &t->wait_elem);
+	spinlock_release (&sema->spin, INTR_OFF);
 }
 
 // 스레드의 우선순위가 변경되었을 떄 donation을 고려해서 우선순위를 다시 결정한다.
 void
 refresh_priority(void){
-	struct list_elem *donation_elem;
-	struct list *curr_donations = &thread_current()->donations;
-	int donations_priority;
-
-	thread_current()->priority = thread_current()->priority_base; // 스레드의 우선순위를 기부 받기 전의 우선순위로 변경한다.
-	if (!list_empty(curr_donations)){ // donation에 스레드가 존재하는지를 먼저 확인한다.
-		list_sort(curr_donations, cmp_d_priority, NULL);
-		donation_elem = list_begin(curr_donations);
-		donations_priority = list_entry(donation_elem, struct thread, d_elem)->priority;
-		if (thread_get_priority() < donations_priority)
-			thread_current()->priority = donations_priority;
+	struct thread *curr = thread_current ();
+	int priority = curr->priority_base; // 스레드의 우선순위를 기부 받기 전의 우선순위로 변경한다.
+	enum intr_level old_level;
+
+	// 잡고 있는 rwlock을 기다리는 스레드들의 우선순위도 반영한다. (rwlock의 스핀락은 pi_lock보다 먼저 잡는다)
+	for (int i = 0; i < RWLOCK_HELD_MAX; i++) {
+		struct rwlock *rw = curr->rw_held[i].rwlock;
+		if (rw == NULL)
+			continue;
+		int waiter_priority = rwlock_waiter_priority (rw);
+		if (priority < waiter_priority)
+			priority = waiter_priority;
 	}
+
+	old_level = spinlock_acquire (&pi_lock);
+	if (!heap_empty (&curr->held_locks)) { // 잡고 있는 락 중 waiter 우선순위가 가장 높은 락만 보면 된다.
+		struct lock *top = heap_entry (heap_top (&curr->held_locks), struct lock, held_elem);
+		if (priority < lock_waiter_priority (top))
+			priority = lock_waiter_priority (top);
+	}
+	curr->priority = priority;
+	spinlock_release (&pi_lock, old_level);
 }
 
-// donation elem 으로 정렬 기준 재지정
+// LOCK을 기다리는 스레드 중 가장 높은 우선순위. LOCK에 waiter가 있어야 한다.
+static int
+lock_waiter_priority (struct lock *lock) {
+	return heap_entry (heap_top (&lock->waiters), struct thread, wait_elem)->priority;
+}
+
+// held_locks 힙의 정렬 기준: 각 락을 기다리는 스레드의 최고 우선순위
+bool
+cmp_lock_priority (const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED) {
+	return lock_waiter_priority (heap_entry (a, struct lock, held_elem))
+		< lock_waiter_priority (heap_entry (b, struct lock, held_elem));
+}
+
+// waiters 힙의 정렬 기준: 기다리는 스레드의 우선순위
 static bool
-cmp_d_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) {
-	return list_entry(a, struct thread, d_elem) -> priority \
-		> list_entry(b, struct thread, d_elem) -> priority ? \
-		1 : 0; 
+cmp_wait_priority (const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED) {
+	return heap_entry (a, struct thread, wait_elem)->priority
+		< heap_entry (b, struct thread, wait_elem)->priority;
 }
 
 /* One semaphore in a list. */
 struct semaphore_elem {
 	struct list_elem elem;              /* List element. */
 	struct semaphore semaphore;         /* This semaphore. */
+	struct thread *thread;              /* Thread waiting on it. */
 };
 
 // Condition variables
 static bool
 cmp_sem_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) {
-	return list_entry (list_begin (&list_entry (a, struct semaphore_elem, elem)->semaphore.waiters), struct thread, elem)->priority \
-		> list_entry (list_begin (&list_entry (b, struct semaphore_elem, elem)->semaphore.waiters), struct thread, elem)->priority;
+	return list_entry (a, struct semaphore_elem, elem)->thread->priority
+		> list_entry (b, struct semaphore_elem, elem)->thread->priority;
 }
 
 /* Initializes condition variable COND.  A condition variable
@@ -372,7 +554,8 @@ cond_wait (struct condition *cond, struct lock *lock) {
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	sema_init (&waiter.semaphore, 0);
+	sema_init_named (&waiter.semaphore, 0, NULL); // cond_wait의 대기는 락 통계에 넣지 않는다.
+	waiter.thread = thread_current ();
 	/*------------------------- [P1] Priority Scheduling - Condition variables --------------------------*/
 	// list_push_back (&cond->waiters, &waiter.elem);
 	list_insert_ordered (&cond->waiters, &waiter.elem, cmp_sem_priority, NULL);
@@ -416,3 +599,406 @@ cond_broadcast (struct condition *cond, struct lock *lock) {
 	while (!list_empty (&cond->waiters))
 		cond_signal (cond, lock);
 }
+
+/*------------------------- [P4] Reader-Writer Lock --------------------------*/
+/* Initializes RW as an unheld reader-writer lock. */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	spinlock_init (&rw->spin);
+	rw->readers = 0;
+	rw->writer = NULL;
+	rw->upgrader = NULL;
+	rw->waiting_writers = 0;
+	list_init (&rw->waiters);
+	list_init (&rw->holders);
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or is
+   waiting for it.  The current thread must not hold RW for
+   writing.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (!rwlock_held_by_current_thread (rw));
+
+	old_level = spinlock_acquire (&rw->spin);
+	if (rw->writer == NULL && rw->upgrader == NULL && rw->waiting_writers == 0) {
+		rw->readers++;
+		rwlock_hold_add (rw, thread_current ());
+		spinlock_release (&rw->spin, old_level);
+	} else
+		rwlock_wait (rw, false, old_level); // writer 우선
+}
+
+/* Tries to acquire RW for reading without sleeping.  Returns true
+   if successful, false if a writer holds RW or is waiting for
+   it. */
+bool
+rwlock_try_acquire_read (struct rwlock *rw) {
+	enum intr_level old_level;
+	bool success;
+
+	ASSERT (rw != NULL);
+	ASSERT (!rwlock_held_by_current_thread (rw));
+
+	old_level = spinlock_acquire (&rw->spin);
+	success = rw->writer == NULL && rw->upgrader == NULL && rw->waiting_writers == 0;
+	if (success) {
+		rw->readers++;
+		rwlock_hold_add (rw, thread_current ());
+	}
+	spinlock_release (&rw->spin, old_level);
+	return success;
+}
+
+/* Releases RW, which the current thread holds for reading. */
+void
+rwlock_release_read (struct rwlock *rw) {
+	enum intr_level old_level;
+	int woken = PRI_MIN - 1;
+
+	ASSERT (rw != NULL);
+
+	old_level = spinlock_acquire (&rw->spin);
+	ASSERT (rw->readers > 0);
+	rwlock_hold_remove (rw, thread_current ());
+	if (--rw->readers == 0) { // 마지막 reader가 나가면 기다리던 스레드에게 넘겨준다.
+		if (rw->upgrader != NULL) { // upgrade를 기다리는 reader가 먼저다.
+			struct thread *t = rw->upgrader;
+			rw->upgrader = NULL;
+			rw->writer = t;
+			t->wait_on_rwlock = NULL;
+			thread_unblock (t);
+			woken = t->priority;
+		} else
+			woken = rwlock_grant (rw);
+	}
+	rwlock_finish_release (rw, woken, old_level);
+}
+
+/* Acquires RW for writing, sleeping until no reader or writer
+   holds it.  The current thread must not already hold RW.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (!rwlock_held_by_current_thread (rw));
+
+	old_level = spinlock_acquire (&rw->spin);
+	if (rw->writer == NULL && rw->readers == 0 && rw->upgrader == NULL) {
+		rw->writer = thread_current ();
+		rwlock_hold_add (rw, thread_current ());
+		spinlock_release (&rw->spin, old_level);
+	} else
+		rwlock_wait (rw, true, old_level);
+}
+
+/* Tries to acquire RW for writing without sleeping.  Returns true
+   if successful, false if RW is held. */
+bool
+rwlock_try_acquire_write (struct rwlock *rw) {
+	enum intr_level old_level;
+	bool success;
+
+	ASSERT (rw != NULL);
+	ASSERT (!rwlock_held_by_current_thread (rw));
+
+	old_level = spinlock_acquire (&rw->spin);
+	success = rw->writer == NULL && rw->readers == 0 && rw->upgrader == NULL;
+	if (success) {
+		rw->writer = thread_current ();
+		rwlock_hold_add (rw, thread_current ());
+	}
+	spinlock_release (&rw->spin, old_level);
+	return success;
+}
+
+/* Releases RW, which the current thread holds for writing.
+   The highest-priority waiting writer goes next if there is one;
+   otherwise all waiting readers are let in. */
+void
+rwlock_release_write (struct rwlock *rw) {
+	enum intr_level old_level;
+	int woken;
+
+	ASSERT (rw != NULL);
+	ASSERT (rwlock_held_by_current_thread (rw));
+
+	old_level = spinlock_acquire (&rw->spin);
+	rwlock_hold_remove (rw, thread_current ());
+	rw->writer = NULL;
+	woken = rwlock_grant (rw);
+	rwlock_finish_release (rw, woken, old_level);
+}
+
+/* Upgrades RW, which the current thread holds for reading, to a
+   write hold if the current thread is its only reader.  Returns
+   true if successful, false otherwise, in which case the current
+   thread still holds RW for reading. */
+bool
+rwlock_try_upgrade (struct rwlock *rw) {
+	enum intr_level old_level;
+	bool success;
+
+	ASSERT (rw != NULL);
+
+	old_level = spinlock_acquire (&rw->spin);
+	ASSERT (rw->readers > 0);
+	success = rw->readers == 1 && rw->upgrader == NULL;
+	if (success) {
+		rw->readers = 0;
+		rw->writer = thread_current ();
+	}
+	spinlock_release (&rw->spin, old_level);
+	return success;
+}
+
+/* Upgrades RW, which the current thread holds for reading, to a
+   write hold, waiting for the other readers to leave.  The
+   upgrade goes ahead of waiting writers.
+
+   Returns true if no other writer held RW in between, so what was
+   read is still valid.  Only one thread can wait to upgrade at a
+   time, since two would wait for each other forever; if another
+   thread is already upgrading, RW is released and reacquired for
+   writing, and this function returns false.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+bool
+rwlock_upgrade (struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	old_level = spinlock_acquire (&rw->spin);
+	ASSERT (rw->readers > 0);
+	if (rw->upgrader == NULL) {
+		if (--rw->readers == 0) {
+			rw->writer = curr;
+			spinlock_release (&rw->spin, old_level);
+			return true;
+		}
+
+		// 다른 reader들이 모두 나갈 때까지 기다린다. (rwlock_release_read가 깨운다)
+		rw->upgrader = curr;
+		curr->wait_on_rwlock = rw;
+		if (!thread_mlfqs) {
+			spinlock_acquire (&pi_lock);
+			rwlock_donate (rw, curr->priority);
+			spinlock_release (&pi_lock, INTR_OFF);
+		}
+		spinlock_release (&rw->spin, INTR_OFF);
+		thread_block ();
+		intr_set_level (old_level);
+
+		if (!thread_mlfqs)
+			refresh_priority ();
+		return true;
+	}
+	spinlock_release (&rw->spin, old_level);
+
+	rwlock_release_read (rw);
+	rwlock_acquire_write (rw);
+	return false;
+}
+
+/* Downgrades RW, which the current thread holds for writing, to a
+   read hold.  Waiting readers are let in too, unless a writer is
+   waiting. */
+void
+rwlock_downgrade (struct rwlock *rw) {
+	enum intr_level old_level;
+	int woken = PRI_MIN - 1;
+
+	ASSERT (rw != NULL);
+	ASSERT (rwlock_held_by_current_thread (rw));
+
+	old_level = spinlock_acquire (&rw->spin);
+	rw->writer = NULL;
+	rw->readers = 1;
+	if (rw->waiting_writers == 0)
+		woken = rwlock_grant_readers (rw);
+	rwlock_finish_release (rw, woken, old_level);
+}
+
+/* Returns true if the current thread holds RW for writing, false
+   otherwise. */
+bool
+rwlock_held_by_current_thread (const struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	return rw->writer == thread_current ();
+}
+
+/* Puts the current thread on RW's wait list and sleeps until
+   rwlock_grant() hands RW over, for writing if WRITE is true or
+   for reading otherwise.  RW's spin lock must be held, and is
+   released; OLD_LEVEL is the interrupt level to restore. */
+static void
+rwlock_wait (struct rwlock *rw, bool write, enum intr_level old_level) {
+	struct thread *curr = thread_current ();
+
+	ASSERT (spinlock_held_by_current_cpu (&rw->spin));
+
+	curr->wait_on_rwlock = rw;
+	curr->rw_want_write = write;
+	if (write)
+		rw->waiting_writers++;
+	list_insert_ordered (&rw->waiters, &curr->elem, cmp_priority, NULL);
+	if (!thread_mlfqs) { // 락을 잡고 있는 writer나 reader들에게 우선순위를 기부한다.
+		spinlock_acquire (&pi_lock);
+		rwlock_donate (rw, curr->priority);
+		spinlock_release (&pi_lock, INTR_OFF);
+	}
+	spinlock_release (&rw->spin, INTR_OFF); // block 될 때까지 인터럽트는 꺼둔다.
+	thread_block ();
+	intr_set_level (old_level);
+
+	if (!thread_mlfqs) // 아직 기다리고 있는 스레드들로부터 다시 donation을 받는다.
+		refresh_priority ();
+}
+
+/* Hands RW, which nobody holds, to its waiters: to the
+   highest-priority waiting writer if there is one, or else to all
+   waiting readers.  RW's spin lock must be held.  Returns the
+   highest priority among the threads woken up, or PRI_MIN - 1 if
+   there were none. */
+static int
+rwlock_grant (struct rwlock *rw) {
+	ASSERT (spinlock_held_by_current_cpu (&rw->spin));
+	ASSERT (rw->writer == NULL && rw->readers == 0 && rw->upgrader == NULL);
+
+	if (rw->waiting_writers == 0)
+		return rwlock_grant_readers (rw);
+
+	list_sort (&rw->waiters, cmp_priority, NULL); // donation으로 우선순위가 바뀌었을 수 있다.
+	for (struct list_elem *e = list_begin (&rw->waiters); e != list_end (&rw->waiters);
+			e = list_next (e)) {
+		struct thread *t = list_entry (e, struct thread, elem);
+		if (t->rw_want_write) {
+			list_remove (e);
+			rw->waiting_writers--;
+			rw->writer = t;
+			rwlock_hold_add (rw, t);
+			t->wait_on_rwlock = NULL;
+			thread_unblock (t);
+			return t->priority;
+		}
+	}
+	NOT_REACHED ();
+}
+
+/* Lets every thread waiting on RW in as a reader.  RW's spin lock
+   must be held and no writer may be waiting.  Returns the highest
+   priority among the threads woken up, or PRI_MIN - 1. */
+static int
+rwlock_grant_readers (struct rwlock *rw) {
+	int woken = PRI_MIN - 1;
+
+	ASSERT (rw->waiting_writers == 0);
+
+	while (!list_empty (&rw->waiters)) {
+		struct thread *t = list_entry (list_pop_front (&rw->waiters), struct thread, elem);
+		rw->readers++;
+		rwlock_hold_add (rw, t);
+		t->wait_on_rwlock = NULL;
+		thread_unblock (t);
+		if (t->priority > woken)
+			woken = t->priority;
+	}
+	return woken;
+}
+
+/* Common tail of the release functions: drops RW's spin lock, gives
+   back priority donated through RW, and yields if a thread with
+   priority WOKEN that was just woken up should run first. */
+static void
+rwlock_finish_release (struct rwlock *rw, int woken, enum intr_level old_level) {
+	spinlock_release (&rw->spin, INTR_OFF); // 양보하기 전에 스핀락을 놓는다.
+
+	if (!thread_mlfqs) // RW를 통해 받은 donation을 돌려준다.
+		refresh_priority ();
+	if (thread_get_priority () < woken)
+		thread_yield ();
+	intr_set_level (old_level);
+}
+
+/* Donates PRIORITY to every thread holding RW, following the
+   chain if those threads are waiting on a lock themselves.
+   pi_lock must be held. */
+static void
+rwlock_donate (struct rwlock *rw, int priority) {
+	ASSERT (spinlock_held_by_current_cpu (&pi_lock));
+
+	if (rw->writer != NULL)
+		donate_to (rw->writer, priority);
+	for (struct list_elem *e = list_begin (&rw->holders); e != list_end (&rw->holders);
+			e = list_next (e))
+		donate_to (list_entry (e, struct rwlock_hold, elem)->holder, priority);
+}
+
+/* Returns the highest priority among the threads waiting for RW,
+   or PRI_MIN - 1 if there are none. */
+static int
+rwlock_waiter_priority (struct rwlock *rw) {
+	int priority = PRI_MIN - 1;
+	enum intr_level old_level = spinlock_acquire (&rw->spin);
+
+	for (struct list_elem *e = list_begin (&rw->waiters); e != list_end (&rw->waiters);
+			e = list_next (e)) {
+		struct thread *t = list_entry (e, struct thread, elem);
+		if (t->priority > priority)
+			priority = t->priority;
+	}
+	if (rw->upgrader != NULL && rw->upgrader != thread_current ()
+			&& rw->upgrader->priority > priority)
+		priority = rw->upgrader->priority;
+
+	spinlock_release (&rw->spin, old_level);
+	return priority;
+}
+
+/* Records in a free rw_held slot of T that T holds RW, so that
+   waiters can donate to T.  If T has no free slot, the hold is not
+   recorded and T does not receive donations through RW. */
+static void
+rwlock_hold_add (struct rwlock *rw, struct thread *t) {
+	for (int i = 0; i < RWLOCK_HELD_MAX; i++) {
+		struct rwlock_hold *hold = &t->rw_held[i];
+		if (hold->rwlock == NULL) {
+			hold->rwlock = rw;
+			hold->holder = t;
+			list_push_back (&rw->holders, &hold->elem);
+			return;
+		}
+	}
+}
+
+/* Removes the record that T holds RW, if there is one. */
+static void
+rwlock_hold_remove (struct rwlock *rw, struct thread *t) {
+	for (int i = 0; i < RWLOCK_HELD_MAX; i++) {
+		struct rwlock_hold *hold = &t->rw_held[i];
+		if (hold->rwlock == rw) {
+			list_remove (&hold->elem);
+			hold->rwlock = NULL;
+			return;
+		}
+	}
+}
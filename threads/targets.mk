@@ -3,7 +3,17 @@ threads_SRC += threads/thread.c		# Thread management core.
 threads_SRC += threads/interrupt.c	# Interrupt core.
 threads_SRC += threads/intr-stubs.S	# Interrupt stubs.
 threads_SRC += threads/synch.c		# Synchronization.
+threads_SRC += threads/spinlock.c	# Spin locks.
+threads_SRC += threads/lockstat.c	# Lock contention profiling.
+threads_SRC += threads/trace.c		# Event tracing.
+threads_SRC += threads/profile.c	# Sampling profiler.
+threads_SRC += threads/scratch.c	# Scratch disk dumps.
+threads_SRC += threads/cpu.c		# Per-CPU state.
+threads_SRC += threads/lapic.c		# Local APIC.
+threads_SRC += threads/ap-start.S	# Application processor startup.
 threads_SRC += threads/palloc.c		# Page allocator.
 threads_SRC += threads/malloc.c		# Subpage allocator.
+threads_SRC += threads/slab.c		# Object caches.
+threads_SRC += threads/magazine.c	# Per-CPU magazines.
 threads_SRC += threads/start.S		# Startup code.
 threads_SRC += threads/mmu.c		    # Memory management unit related things.
@@ -4,12 +4,16 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/lapic.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -24,15 +28,41 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-
-/*------------------------- [P1] Alarm Clock --------------------------*/
-static struct list sleep_list; // sleep_list 추가
+/*------------------------- [P1] Priority Scheduling - O(1) Run Queue --------------------------*/
+#if PRI_MAX - PRI_MIN + 1 != RQ_LEVELS
+#error struct runqueue needs exactly one queue per priority
+#endif
 
-/* Idle thread. */
-static struct thread *idle_thread;
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running, wait in the run queue of
+   some CPU (struct runqueue in threads/cpu.h).  Each run queue has
+   one FIFO list per priority level, and bit N of its bitmap is set
+   iff queues[N] is non-empty, so the highest ready priority is
+   found with a single bit scan.  A ready thread's `cpu' member
+   names the CPU whose run queue holds it. */
+
+/*------------------------- [P1] Alarm Clock - Timing Wheel --------------------------*/
+/* Sleeping threads live in a hierarchical timing wheel.  Level 0
+   has one slot per tick for the next WHEEL_SIZE ticks, and each
+   slot of level N covers WHEEL_SIZE^N ticks.  A sleeper goes into
+   the slot for its wakeup tick at the lowest level that can hold
+   it; whenever a level wraps around, the next slot of the level
+   above is cascaded, that is, its sleepers are re-inserted one or
+   more levels down.  thread_sleep() is O(1), and each tick does
+   O(1) work plus the sleepers it wakes or cascades. */
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)    /* Slots per level. */
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4                  /* 2^24 ticks, about 46 hours. */
+#define WHEEL_MAX_DELTA ((1LL << (WHEEL_BITS * WHEEL_LEVELS)) - 1)
+
+static struct list sleep_wheel[WHEEL_LEVELS][WHEEL_SIZE];
+static int64_t wheel_ticks;     /* Next tick the wheel will process. */
+static size_t sleeper_cnt;      /* # of threads in the wheel. */
+
+/*------------------------- [P1] SMP --------------------------*/
+/* Protects the sleep wheel. */
+static struct spinlock sleep_lock;
 
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
@@ -40,28 +70,77 @@ static struct thread *initial_thread;
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
 
-/* Thread destruction requests */
-static struct list destruction_req;
-
-/*------------------------- [P1] Alarm Clock --------------------------*/
-/* Define global ticks */
-static int64_t global_ticks = INT64_MAX; // 초기 global_ticks 비교를 위해서 최대값을 설정해준다.
-
-/* Statistics. */
-static long long idle_ticks;    /* # of timer ticks spent idle. */
-static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
-static long long user_ticks;    /* # of timer ticks in user programs. */
+/* Protects every thread's child_list and child_elem: a parent and
+   its children may run on different CPUs. */
+struct spinlock thread_child_lock;
+
+/* Threads become READY and get on a run queue before the CPU they
+   ran on has finished switching away from them (see
+   thread_yield() and thread_block()).  A thread's `on_cpu' member
+   stays true until the next thread on that CPU has taken over, in
+   finish_switch(), and work stealing leaves such threads alone.
+   That also keeps the `cpu' member of a running thread fixed, which
+   this_cpu() relies on.  Exited threads wait on their CPU's `dying'
+   list until it has switched away from them. */
+
+/*------------------------- [P1] Thread Cache --------------------------*/
+/* 종료된 스레드의 페이지는 palloc에 돌려주지 않고 여기에 모아두었다가
+   thread_create()에서 그대로 재사용한다. */
+#define THREAD_CACHE_MAX 32             /* 캐시에 보관할 최대 페이지 수. */
+static struct list thread_cache;
+static size_t thread_cache_cnt;
+static struct spinlock thread_cache_lock;
+
+/* Statistics and the idle thread are per CPU: see struct cpu. */
 
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
-static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/*------------------------- [P1] Advanced Scheduler --------------------------*/
+/* The MLFQS only touches the running thread on an ordinary tick.
+   Once a second, load_avg is updated and the recent_cpu decay
+   coefficient for that second is recorded in decay_history; the
+   running thread and the ready threads are brought up to date
+   then, but blocked threads are not.  A blocked thread replays
+   the decays it missed when it is unblocked, so the per-second
+   work is O(ready threads) rather than O(all threads).  Decays
+   older than DECAY_HISTORY seconds are dropped: by then the
+   newer ones have already decayed the old value away. */
+#define PRI_RECALC_TICKS 4      /* Recompute priority this often. */
+#define DECAY_HISTORY 1024      /* Seconds of decay history kept. */
+
+static fixed_t load_avg;        /* System load average. */
+static int64_t mlfqs_seconds;   /* # of load_avg updates so far. */
+static fixed_t decay_history[DECAY_HISTORY]; /* Decay of each second. */
+
+/*------------------------- [P1] Scheduler Accounting --------------------------*/
+/* -schedstat: print a scheduling report at power off, with the
+   exited threads that waited longest in run queues. */
+bool thread_schedstat;
+
+#define SCHED_REPORT_MAX 10     /* Exited threads kept for the report. */
+
+struct sched_report {
+	char name[16];                      /* Thread name. */
+	tid_t tid;                          /* Thread identifier. */
+	struct sched_stats stats;           /* Its statistics at exit. */
+};
+
+static struct sched_report sched_reports[SCHED_REPORT_MAX];
+static struct spinlock sched_report_lock;
+
+static void sched_account_wait (struct sched_stats *, uint64_t wait_ns);
+static void sched_report_add (struct thread *);
+static void sched_print_stats (const struct sched_stats *);
+
 static void kernel_thread (thread_func *, void *aux);
+static void finish_switch (void);
+static intr_handler_func resched_interrupt;
 
 static void idle (void *aux UNUSED);
 static struct thread *next_thread_to_run (void);
@@ -69,10 +148,25 @@ static void init_thread (struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule (void);
 static tid_t allocate_tid (void);
+static void runqueue_init (struct runqueue *);
+static void ready_queue_push (struct runqueue *, struct thread *);
+static void ready_queue_remove (struct runqueue *, struct thread *);
+static struct thread *ready_queue_pop (struct runqueue *);
+static int ready_max_priority (struct runqueue *);
+static int ready_thread_cnt (void);
+static bool is_idle_thread (struct thread *);
+static struct runqueue *lock_thread_runqueue (struct thread *);
+static void steal_work (struct cpu *);
+static void sleep_wheel_insert (struct thread *);
+static void sleep_wheel_cascade (int level, int idx);
+static void mlfqs_tick (struct thread *, int64_t tick);
+static void mlfqs_update_second (struct thread *);
+static void mlfqs_catch_up (struct thread *);
+static int mlfqs_priority (struct thread *);
+static struct thread *thread_cache_get (void);
+static void thread_cache_put (struct thread *);
 
 /*------------------------- [P1] Alarm Clock & Priority Scheduling --------------------------*/
-int64_t get_global_ticks(void);
-void set_global_ticks(int64_t ticks);
 void thread_awake(int64_t ticks);
 void thread_sleep(int64_t ticks);
 bool cmp_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
@@ -123,14 +217,32 @@ thread_init (void) {
 	/*------------------------- [P1] Alarm Clock --------------------------*/
 	/* Init the globla thread context */
 	lock_init (&tid_lock);
-	list_init (&ready_list);
-	list_init (&sleep_list); // sleep_list를 초기화 한다.
-	list_init (&destruction_req);
+	for (int i = 0; i < NCPU_MAX; i++) {
+		runqueue_init (&cpus[i].rq); // CPU별 ready 큐를 초기화한다.
+		list_init (&cpus[i].dying);
+	}
+	spinlock_init (&thread_child_lock);
+	spinlock_init (&sleep_lock);
+	spinlock_init (&sched_report_lock);
+	for (int level = 0; level < WHEEL_LEVELS; level++)
+		for (int idx = 0; idx < WHEEL_SIZE; idx++)
+			list_init (&sleep_wheel[level][idx]); // 타이밍 휠의 슬롯들을 초기화 한다.
+	wheel_ticks = 0;
+	sleeper_cnt = 0;
+	load_avg = int_to_fp (0);
+	mlfqs_seconds = 0;
+	list_init (&thread_cache);
+	thread_cache_cnt = 0;
+	spinlock_init (&thread_cache_lock);
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread ();
 	init_thread (initial_thread, "main", PRI_DEFAULT);
+	initial_thread->cpu = &cpus[0]; // this_cpu()가 동작하도록 실행 중인 CPU를 기록한다.
 	initial_thread->status = THREAD_RUNNING;
+	initial_thread->on_cpu = true;
+	cpus[0].curr = initial_thread;
+	cpus[0].online = true; // 이제 this_cpu()가 스레드에서 CPU를 찾는다. 아직 BSP만 실행 중이다.
 	initial_thread->tid = allocate_tid ();
 }
 
@@ -142,6 +254,7 @@ thread_start (void) {
 	struct semaphore idle_started;
 	sema_init (&idle_started, 0);
 	thread_create ("idle", PRI_MIN, idle, &idle_started);
+	intr_register_ext (LAPIC_RESCHED_VEC, resched_interrupt, "Reschedule IPI");
 
 	/* Start preemptive thread scheduling. */
 	intr_enable ();
@@ -150,32 +263,145 @@ thread_start (void) {
 	sema_down (&idle_started);
 }
 
-/* Called by the timer interrupt handler at each timer tick.
-   Thus, this function runs in an external interrupt context. */
+/* Sets up the idle thread that application processor C starts on.
+   An AP enters the kernel with no thread of its own, so this
+   thread's page doubles as its boot stack (see cpu_start_aps()).
+   Returns a null pointer if out of memory. */
+struct thread *
+thread_init_ap (struct cpu *c) {
+	struct thread *t = thread_cache_get ();
+	char name[16];
+
+	ASSERT (c != &cpus[0]);
+
+	if (t == NULL)
+		return NULL;
+	snprintf (name, sizeof name, "idle%d", c->id);
+	init_thread (t, name, PRI_MIN);
+	t->tid = allocate_tid ();
+	t->cpu = c;
+	t->status = THREAD_RUNNING;
+	t->on_cpu = true;
+	c->idle_thread = c->curr = t;
+	return t;
+}
+
+/* Called by ap_main() once the running application processor is
+   set up.  Brings it online, so that thread_unblock() and work
+   stealing can give it threads, and runs its idle thread. */
 void
-thread_tick (void) {
+thread_start_ap (void) {
+	struct cpu *c = this_cpu ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (thread_current () == c->idle_thread);
+
+	c->online = true;
+	idle (NULL);
+	NOT_REACHED ();
+}
+
+/* Called by the timer interrupt handler at each timer tick, TICK
+   being the value of timer_ticks() at that tick.
+   Thus, this function runs in an external interrupt context.
+   USER tells whether the tick interrupted user code. */
+void
+thread_tick (int64_t tick, bool user) {
 	struct thread *t = thread_current ();
+	struct cpu *c = this_cpu ();
 
 	/* Update statistics. */
-	if (t == idle_thread)
-		idle_ticks++;
+	if (t == c->idle_thread)
+		c->idle_ticks++;
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
-		user_ticks++;
+		c->user_ticks++;
 #endif
 	else
-		kernel_ticks++;
+		c->kernel_ticks++;
+
+	if (t != c->idle_thread) { // 스레드별로는 실제로 어느 모드에서 틱이 지났는지 센다.
+		if (user)
+			t->stats.user_ticks++;
+		else
+			t->stats.kernel_ticks++;
+	}
+
+	/*------------------------- [P1] Advanced Scheduler --------------------------*/
+	if (thread_mlfqs) {
+		mlfqs_tick (t, tick);
+
+		/* 실행 중인 스레드보다 높은 우선순위의 스레드가 생기면 양보한다. */
+		if (t->priority < ready_max_priority (&c->rq))
+			intr_yield_on_return ();
+	}
 
 	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	if (++c->thread_ticks >= TIME_SLICE)
 		intr_yield_on_return ();
 }
 
+/* Called by the timer interrupt handler for tick TICK, which went
+   by while this CPU was halted in tickless idle.  The tick is
+   charged to the idle thread even if another thread is running
+   by the time the interrupt comes in. */
+void
+thread_idle_tick (int64_t tick) {
+	struct cpu *c = this_cpu ();
+
+	c->idle_ticks++;
+	if (thread_mlfqs)
+		mlfqs_tick (c->idle_thread, tick);
+}
+
 /* Prints thread statistics. */
 void
 thread_print_stats (void) {
+	long long idle_ticks = 0, kernel_ticks = 0, user_ticks = 0;
+
+	for (int i = 0; i < cpu_cnt; i++) {
+		idle_ticks += cpus[i].idle_ticks;
+		kernel_ticks += cpus[i].kernel_ticks;
+		user_ticks += cpus[i].user_ticks;
+	}
 	printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 			idle_ticks, kernel_ticks, user_ticks);
+
+	if (thread_schedstat) {
+		struct sched_stats total;
+
+		memset (&total, 0, sizeof total);
+		for (int i = 0; i < cpu_cnt; i++) {
+			const struct sched_stats *s = &cpus[i].sched;
+
+			total.voluntary_switches += s->voluntary_switches;
+			total.involuntary_switches += s->involuntary_switches;
+			total.runq_wait_ns += s->runq_wait_ns;
+			if (s->runq_wait_max_ns > total.runq_wait_max_ns)
+				total.runq_wait_max_ns = s->runq_wait_max_ns;
+			for (int b = 0; b < SCHED_HIST_BUCKETS; b++)
+				total.runq_wait_hist[b] += s->runq_wait_hist[b];
+		}
+		sched_print_stats (&total);
+	}
+
+	if (cpu_online_cnt () > 1)
+		for (int i = 0; i < cpu_cnt; i++)
+			if (cpus[i].online)
+				printf ("  cpu%d: %lld idle ticks, %lld kernel ticks, %lld user ticks, "
+						"%lld steals, %lld migrations\n",
+						i, cpus[i].idle_ticks, cpus[i].kernel_ticks,
+						cpus[i].user_ticks, cpus[i].steals, cpus[i].migrations);
+}
+
+/* Returns the number of context switches so far on all CPUs. */
+long long
+thread_switch_cnt (void) {
+	long long switches = 0;
+
+	for (int i = 0; i < cpu_cnt; i++)
+		switches += cpus[i].switches;
+	return switches;
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -201,27 +427,38 @@ thread_create (const char *name, int priority, thread_func *function, void *aux)
 	ASSERT (function != NULL);
 
 	/* Allocate thread. */
-	t = palloc_get_page (PAL_ZERO);
+	t = thread_cache_get ();
 	if (t == NULL)
 		return TID_ERROR;
 
 	/* Initialize thread. */
 	init_thread (t, name, priority);
 	tid = t->tid = allocate_tid ();
+
+	/*------------------------- [P1] Advanced Scheduler --------------------------*/
+	/* idle 스레드는 처음 ready 큐에 들어갈 때부터 idle로 알아볼 수 있어야
+	   MLFQS 재계산에서 빠지고 PRI_MIN에 머문다. */
+	if (function == idle) {
+		t->cpu = this_cpu ();
+		t->cpu->idle_thread = t;
+	}
+	/* MLFQS에서는 우선순위 인자를 무시하고, 부모의 nice와 recent_cpu를 물려받는다. */
+	else if (thread_mlfqs) {
+		struct thread *parent = thread_current ();
+		t->nice = parent->nice;
+		t->recent_cpu = parent->recent_cpu;
+		t->priority = t->priority_base = mlfqs_priority (t);
+	}
 	
 	/*------------------------- [P2] System Call --------------------------*/
-	t->fdt = palloc_get_multiple(PAL_ZERO, FDT_PAGES);
-	if (t->fdt == NULL) {
-		return TID_ERROR;
-	}
-	t->next_fd = 2; // 0 : stdin, 1 : stdout
-	t->fdt[0] = 1; // STDIN_FILENO -> dummy value
-	t->fdt[1] = 2; // STDOUT_FILENO -> dummy value
+	fdt_init (&t->fdt); // fdt는 처음 파일을 열 때 할당한다. (fdt_add)
 
 /*------------------------- [P2] System Call - Thread --------------------------*/
 	/* 현재 스레드의 자식 리스트에 새로 생성한 스레드 추가 */
     struct thread *curr = thread_current();
+    enum intr_level old_level = spinlock_acquire (&thread_child_lock);
     list_push_back(&curr->child_list,&t->child_elem);
+    spinlock_release (&thread_child_lock, old_level);
 
 	/* Call the kernel_thread if it scheduled.
 	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
@@ -236,9 +473,9 @@ thread_create (const char *name, int priority, thread_func *function, void *aux)
 
 	/*------------------------- [P1] Priority Scheduling --------------------------*/
 	/* Add to run queue. */
-	thread_unblock (t); // ready_list 에 새로 넣은 스레드 
+	thread_unblock (t); // ready 큐에 새로 넣은 스레드 
 
-	if (thread_get_priority() < priority) { //1. 현재 실행중인 스레드와 새로 추가하려는 스레드 비교
+	if (thread_get_priority() < t->priority) { //1. 현재 실행중인 스레드와 새로 추가하려는 스레드 비교
 		thread_yield(); //2. 만약 새로 추가하려는 스레드가 현재 실행중인 스레드보다 우선순위가 높으면 CPU를 선점한다.
 	}
 	
@@ -260,7 +497,7 @@ thread_block (void) {
 	schedule ();
 }
 
-// BLOCKED 상태의 스레드를 READY 상태로 전환하고 ready_list에 삽입한다.
+// BLOCKED 상태의 스레드를 READY 상태로 전환하고 ready 큐에 삽입한다.
 /* Transitions a blocked thread T to the ready-to-run state.
    This is an error if T is not blocked.  (Use thread_yield() to
    make the running thread ready.)
@@ -268,21 +505,45 @@ thread_block (void) {
    This function does not preempt the running thread.  This can
    be important: if the caller had disabled interrupts itself,
    it may expect that it can atomically unblock a thread and
-   update other data. */
+   update other data.  If T goes to another CPU's run queue and
+   should run ahead of what that CPU is running, that CPU is
+   interrupted to reschedule.
+
+   T may still be on its way into thread_block() on another CPU,
+   having put itself on a wait list and released that list's spin
+   lock with interrupts off; wait for it to get there. */
 void
 thread_unblock (struct thread *t) {
+	struct cpu *c;
 	enum intr_level old_level;
+	bool kick;
 
 	ASSERT (is_thread (t));
 
+	while (*(volatile enum thread_status *) &t->status == THREAD_RUNNING)
+		asm volatile ("pause" : : : "memory");
+
+	/* 마지막으로 실행됐던 CPU의 ready 큐로 돌려보낸다. */
 	old_level = intr_disable ();
+	c = t->cpu != NULL && t->cpu->online ? t->cpu : this_cpu ();
+	spinlock_acquire (&c->rq.lock);
 	ASSERT (t->status == THREAD_BLOCKED);
 	/*------------------------- [P1] Priority Scheduling --------------------------*/
 	/* origin code
 	list_push_back (&ready_list, &t->elem);
 	*/
-	list_insert_ordered(&ready_list, &t -> elem, cmp_priority, NULL); // 정렬된 상태로 스레드가 삽입되도록 한다.
+	if (thread_mlfqs && !is_idle_thread (t)) { // 자는 동안 놓친 decay를 반영하고 우선순위를 다시 계산한다.
+		mlfqs_catch_up (t);
+		t->priority = mlfqs_priority (t);
+	}
+	t->cpu = c;
+	ready_queue_push (&c->rq, t); // 우선순위에 해당하는 큐의 맨 뒤에 O(1)로 삽입한다.
 	t->status = THREAD_READY;
+	kick = c != this_cpu ()
+		&& (c->curr == c->idle_thread || c->curr->priority < t->priority);
+	spinlock_release (&c->rq.lock, INTR_OFF);
+	if (kick)
+		lapic_send_ipi (c->apic_id, LAPIC_RESCHED_VEC);
 	intr_set_level (old_level);
 }
 
@@ -328,6 +589,9 @@ thread_exit (void) {
 	process_exit ();
 #endif
 
+	if (thread_schedstat)
+		sched_report_add (curr);
+
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();
@@ -335,6 +599,31 @@ thread_exit (void) {
 	NOT_REACHED ();
 }
 
+/*------------------------- [P1] Lock Handoff --------------------------*/
+/* Asks for the current thread to yield as soon as it turns
+   interrupts back on, for code that wakes up a higher-priority
+   thread while interrupts are off and should not be switched
+   away in the middle of its critical section. */
+void
+thread_defer_yield (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	this_cpu ()->yield_deferred = true;
+}
+
+/* Called by intr_enable(): performs a yield requested with
+   thread_defer_yield(), if any.  A context switch in between
+   already gave the CPU away, so it cancels the request. */
+void
+thread_run_deferred_yield (void) {
+	struct cpu *c = this_cpu ();
+
+	if (c != NULL && c->yield_deferred) {
+		c->yield_deferred = false;
+		thread_yield ();
+	}
+}
+
 /* Yields the CPU.  The current thread is not put to sleep and
    may be scheduled again immediately at the scheduler's whim. */
 void
@@ -345,20 +634,23 @@ thread_yield (void) {
 	ASSERT (!intr_context ());
 
 	old_level = intr_disable (); // 인터럽터를 비활성화한다.
-	if (curr != idle_thread) { // 현재 스레드가 유휴 스레드가 아니면 리스트의 맨 뒤로 넣는다.
+	if (!is_idle_thread (curr)) { // 현재 스레드가 유휴 스레드가 아니면 리스트의 맨 뒤로 넣는다.
 		/*------------------------- [P1] Alarm Clock --------------------------*/
 		/* origin code
 		list_push_back (&ready_list, &curr->elem); // 현재 스레드를 레디리스트의 맨 뒤로 삽입한다.
 		*/
 		/*------------------------- [P1] Priority Scheduling --------------------------*/
-		list_insert_ordered(&ready_list, &curr -> elem, cmp_priority, NULL); // 정렬된 상태로 스레드가 삽입되도록 한다.
+		struct runqueue *rq = &this_cpu ()->rq;
+		spinlock_acquire (&rq->lock);
+		ready_queue_push (rq, curr); // 같은 우선순위 큐의 맨 뒤로 넣어 round-robin을 유지한다.
+		spinlock_release (&rq->lock, INTR_OFF);
 	}
 	do_schedule (THREAD_READY); // ready 상태로 전환하고 컨텍스트 스위칭을 한다.
 	intr_set_level (old_level); // 이후 다시 이전 상태로 되돌린다.
 }
 
 // 해당 스레드를 sleep시킨다.
-// ↳ 스레드 상태를 blocked로 만들고 sleep_list에 삽입, 새 스레드를 running상태로 만든다.(컨텍스트 스위치)
+// ↳ 스레드 상태를 blocked로 만들고 타이밍 휠에 삽입, 새 스레드를 running상태로 만든다.(컨텍스트 스위치)
 void
 thread_sleep(int64_t ticks){ // ticks : 해당 스레드가 깨어나야 할 절대적인 시간 (eg. 12:05)
 	struct thread *curr = thread_current (); // 현재 스레드의 포인터
@@ -366,15 +658,14 @@ thread_sleep(int64_t ticks){ // ticks : 해당 스레드가 깨어나야 할 절
 
 	ASSERT (!intr_context ());
 
-	old_level = intr_disable (); // 인터럽터를 비활성화 시킨다.
-	if (curr != idle_thread) // 현재 스레드가 유휴 스레드가 아니면 sleep_list의 맨 뒤로 넣는다.
+	old_level = spinlock_acquire (&sleep_lock); // 인터럽터를 비활성화 시키고 타이밍 휠을 잠근다.
+	if (!is_idle_thread (curr)) // 현재 스레드가 유휴 스레드가 아니면 타이밍 휠에 넣는다.
 	{
 		curr -> wakeup_tick = ticks; // 깨워야할 시간으로 새로 받은 인자를 넣는다.
-		list_push_back (&sleep_list, &curr->elem); // 현재 스레드를 레디리스트의 맨 뒤로 삽입한다.
-		// curr -> status = THREAD_BLOCKED; 
-
-		set_global_ticks(ticks);
+		sleep_wheel_insert (curr); // O(1)로 wakeup_tick에 해당하는 슬롯에 넣는다.
+		sleeper_cnt++;
 	}
+	spinlock_release (&sleep_lock, INTR_OFF); // thread_block() 전까지 인터럽트는 꺼둔다.
 	
 	/* 스레드의 상태를 BLOCKED로 전환하고 컨텍스트 스위치(schedule())를 수행한다. */
 	thread_block();
@@ -382,39 +673,106 @@ thread_sleep(int64_t ticks){ // ticks : 해당 스레드가 깨어나야 할 절
 	intr_set_level (old_level); // 이후 다시 인터럽터를 활성화한다.
 }
 
-// global ticks를 가져온다.
-// Hanyang Univ's func : get_next_tick_to_awake
-int64_t 
-get_global_ticks(){
-	return global_ticks;
-}
-
-// local ticks(각 스레드 wakeup_tick)가 global ticks보다 작을 때, global ticks을 갱신한다.
-// Hanyang Univ's func : update_next_tick_to_awake
+// time_interrupt가 발생한 시각(ticks (eg. 12시))까지 타이밍 휠을 돌리면서 깨워야할 스레드를 깨운다.
+/* Advances the sleep wheel up to and including tick TICKS,
+   waking every thread whose wakeup_tick has been reached.
+   Called from the timer interrupt on every tick. */
 void 
-set_global_ticks(int64_t ticks){
-	if (ticks < global_ticks) {
-		global_ticks = ticks;
+thread_awake(int64_t ticks){
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spinlock_acquire (&sleep_lock);
+
+	while (sleeper_cnt > 0 && wheel_ticks <= ticks) {
+		int64_t now = wheel_ticks;
+		struct list *slot = &sleep_wheel[0][now & WHEEL_MASK];
+
+		/* 하위 레벨이 한 바퀴 돌았으면 상위 레벨의 다음 슬롯을 내려보낸다. */
+		for (int level = 1; level < WHEEL_LEVELS; level++) {
+			if ((now & ((1LL << (WHEEL_BITS * level)) - 1)) != 0)
+				break;
+			sleep_wheel_cascade (level, (now >> (WHEEL_BITS * level)) & WHEEL_MASK);
+		}
+
+		while (!list_empty (slot)) { // 이번 틱에 깨어나야 하는 스레드만 슬롯에 남아있다.
+			struct thread *t = list_entry (list_pop_front (slot), struct thread, elem);
+			ASSERT (t->wakeup_tick <= now);
+			sleeper_cnt--;
+			thread_unblock (t); // 레디 상태로 만듦(unblocked)
+		}
+		wheel_ticks++;
 	}
+
+	if (sleeper_cnt == 0) // 자는 스레드가 없으면 휠을 현재 시각으로 바로 맞춘다.
+		wheel_ticks = ticks + 1;
+	spinlock_release (&sleep_lock, INTR_OFF);
 }
 
-// time_interrupt가 발생한 시각(ticks (eg. 12시))보다 깨워야할 시각이 작은 스레드를 깨운다.
-void 
-thread_awake(int64_t ticks){
-	struct list_elem *curr = list_begin(&sleep_list);
-	set_global_ticks(INT64_MAX); // 기존 글로벌 틱으로 비교하면 초기화되지 않음 
-	struct thread *curr_thread;
-	while (curr != list_end(&sleep_list)){ // 전체 순회
-		curr_thread = list_entry(curr, struct thread, elem);
-		if (curr_thread -> wakeup_tick <= ticks) { 
-			curr = list_remove(curr); // curr을 슬립 리스트에서 뻄
-			thread_unblock(curr_thread); // curr을 레디 상태로 만듦(unblocked)
-		} else {
-			set_global_ticks(curr_thread -> wakeup_tick);
-			// 슬립 리스트에서 현재 깨어나야하는 시간이 ticks 보다 클때, 디음 루틴을 위해 글로벌 틱을 재설정한다.
-			curr = curr -> next;
-		}
+/*------------------------- [P1] Tickless Idle --------------------------*/
+/* Returns the earliest tick, no later than LIMIT, that the sleep
+   wheel has to process: either a tick with a sleeper due or the
+   next wrap of level 0, where a cascade may bring one down.
+   Returns LIMIT if nothing happens before then.  Used by the
+   timer to decide how long an idle CPU may go without a tick. */
+int64_t
+thread_next_wakeup (int64_t limit) {
+	int64_t next;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spinlock_acquire (&sleep_lock);
+	if (sleeper_cnt > 0) {
+		int64_t wrap = (wheel_ticks | WHEEL_MASK) + 1; // 상위 레벨 슬롯이 내려올 수 있는 시각
+		if (limit > wrap)
+			limit = wrap;
+		/* wrap 이전에 만료되는 스레드는 모두 레벨 0에 있다. */
+		for (next = wheel_ticks; next < limit; next++)
+			if (!list_empty (&sleep_wheel[0][next & WHEEL_MASK]))
+				break;
+	} else
+		next = limit;
+	spinlock_release (&sleep_lock, INTR_OFF);
+	return next;
+}
+
+/*------------------------- [P1] Alarm Clock - Timing Wheel --------------------------*/
+/* Puts sleeping thread T into the slot for its wakeup_tick at the
+   lowest wheel level whose range covers it.  sleep_lock must be
+   held. */
+static void
+sleep_wheel_insert (struct thread *t) {
+	int64_t expires = t->wakeup_tick > wheel_ticks ? t->wakeup_tick : wheel_ticks;
+	int64_t delta = expires - wheel_ticks;
+	int level;
+
+	ASSERT (spinlock_held_by_current_cpu (&sleep_lock));
+
+	/* 휠 범위를 넘어가면 가장 먼 슬롯에 넣어두고, 내려올 때 다시 자리를 찾는다. */
+	if (delta > WHEEL_MAX_DELTA) {
+		delta = WHEEL_MAX_DELTA;
+		expires = wheel_ticks + delta;
 	}
+
+	for (level = 0; level < WHEEL_LEVELS - 1; level++)
+		if (delta < 1LL << (WHEEL_BITS * (level + 1)))
+			break;
+
+	list_push_back (&sleep_wheel[level][(expires >> (WHEEL_BITS * level)) & WHEEL_MASK],
+			&t->elem);
+}
+
+/* Re-inserts every sleeper in slot IDX of wheel LEVEL, relative to
+   the current wheel time.  They all land in lower levels. */
+static void
+sleep_wheel_cascade (int level, int idx) {
+	struct list *slot = &sleep_wheel[level][idx];
+	struct list pending;
+
+	list_init (&pending);
+	while (!list_empty (slot))
+		list_push_back (&pending, list_pop_front (slot));
+	while (!list_empty (&pending))
+		sleep_wheel_insert (list_entry (list_pop_front (&pending), struct thread, elem));
 }
 
 /*------------------------- [P1] Priority Scheduling --------------------------*/
@@ -422,14 +780,40 @@ thread_awake(int64_t ticks){
 // 현재 스레드의 우선 순위를 변경한다.
 void
 thread_set_priority (int new_priority) {
+	if (thread_mlfqs) // MLFQS에서는 스케줄러가 우선순위를 결정한다.
+		return;
+
 	thread_current ()->priority_base = new_priority;
 	refresh_priority ();
 
-	if (thread_get_priority () < list_entry (list_begin (&ready_list), struct thread, elem)->priority) {
+	if (thread_get_priority () < ready_max_priority (&this_cpu ()->rq)) {
 		thread_yield ();
 	}
 }
 
+/* Changes T's effective priority to NEW_PRIORITY.  If T is on a
+   run queue, it is moved to the queue for its new priority so
+   that next_thread_to_run() keeps picking the right thread. */
+// priority donation 처럼 다른 스레드의 우선순위를 바꿀 때 사용한다.
+void
+thread_change_priority (struct thread *t, int new_priority) {
+	enum intr_level old_level;
+
+	ASSERT (is_thread (t));
+	ASSERT (PRI_MIN <= new_priority && new_priority <= PRI_MAX);
+
+	old_level = intr_disable ();
+	if (t->status == THREAD_READY && t->priority != new_priority) {
+		struct runqueue *rq = lock_thread_runqueue (t); // 다른 CPU로 옮겨갔을 수도 있다.
+		ready_queue_remove (rq, t); // 기존 우선순위 큐에서 빼고
+		t->priority = new_priority;
+		ready_queue_push (rq, t); // 새 우선순위 큐의 맨 뒤로 옮긴다.
+		spinlock_release (&rq->lock, INTR_OFF);
+	} else
+		t->priority = new_priority;
+	intr_set_level (old_level);
+}
+
 /* Returns the current thread's priority. */
 // 현재 실행중인 스레드의 우선 순위 리턴
 int
@@ -447,31 +831,225 @@ cmp_priority (const struct list_elem *a, const struct list_elem *b, void *aux UN
 		1 : 0; 
 }
 
+/*------------------------- [P1] Advanced Scheduler --------------------------*/
 /* Sets the current thread's nice value to NICE. */
 void
-thread_set_nice (int nice UNUSED) {
-	/* TODO: Your implementation goes here */
+thread_set_nice (int nice) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (NICE_MIN <= nice && nice <= NICE_MAX);
+
+	old_level = intr_disable ();
+	curr->nice = nice;
+	curr->priority = mlfqs_priority (curr); // nice가 바뀌면 우선순위도 바로 다시 계산한다.
+	if (curr->priority < ready_max_priority (&this_cpu ()->rq))
+		thread_yield ();
+	intr_set_level (old_level);
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable ();
+	int load_avg_100 = fp_to_int_round (fp_mul_int (load_avg, 100));
+	intr_set_level (old_level);
+	return load_avg_100;
+}
+
+/*------------------------- [P1] Scheduler Accounting --------------------------*/
+/* Copies T's scheduling statistics into *STATS. */
+void
+thread_get_stats (struct thread *t, struct sched_stats *stats) {
+	enum intr_level old_level = intr_disable ();
+	*stats = t->stats;
+	intr_set_level (old_level);
+}
+
+/* Adds a run queue wait of WAIT_NS to STATS. */
+static void
+sched_account_wait (struct sched_stats *stats, uint64_t wait_ns) {
+	uint64_t us = wait_ns / 1000;
+	int bucket = 0;
+
+	while (us > 0 && bucket < SCHED_HIST_BUCKETS - 1) { // log2 버킷을 찾는다.
+		us >>= 1;
+		bucket++;
+	}
+	stats->runq_wait_hist[bucket]++;
+	stats->runq_wait_ns += wait_ns;
+	if (wait_ns > stats->runq_wait_max_ns)
+		stats->runq_wait_max_ns = wait_ns;
+}
+
+/* Keeps exiting thread T for the power-off report if it waited
+   longer in run queues than one of the threads kept so far. */
+static void
+sched_report_add (struct thread *t) {
+	struct sched_report *victim = &sched_reports[0];
+	enum intr_level old_level = spinlock_acquire (&sched_report_lock);
+
+	for (int i = 1; i < SCHED_REPORT_MAX; i++)
+		if (sched_reports[i].stats.runq_wait_ns < victim->stats.runq_wait_ns)
+			victim = &sched_reports[i];
+	if (t->stats.runq_wait_ns > victim->stats.runq_wait_ns) {
+		strlcpy (victim->name, t->name, sizeof victim->name);
+		victim->tid = t->tid;
+		victim->stats = t->stats;
+	}
+	spinlock_release (&sched_report_lock, old_level);
+}
+
+/* Prints the switch counts and run queue wait histogram in
+   TOTAL, then the exited threads kept by sched_report_add(). */
+static void
+sched_print_stats (const struct sched_stats *total) {
+	int64_t waits = 0;
+
+	for (int b = 0; b < SCHED_HIST_BUCKETS; b++)
+		waits += total->runq_wait_hist[b];
+
+	printf ("Scheduler: %lld voluntary switches, %lld involuntary switches\n",
+			total->voluntary_switches, total->involuntary_switches);
+	printf ("Run queue wait: %lld waits, %llu us average, %llu us max\n",
+			waits, waits > 0 ? total->runq_wait_ns / 1000 / waits : 0,
+			total->runq_wait_max_ns / 1000);
+	for (int b = 0; b < SCHED_HIST_BUCKETS; b++)
+		if (total->runq_wait_hist[b] > 0)
+			printf ("  >= %8llu us: %10u\n",
+					b > 0 ? 1ULL << (b - 1) : 0ULL, total->runq_wait_hist[b]);
+
+	printf ("Longest waiting exited threads:\n");
+	printf ("  %-16s %5s %8s %8s %8s %8s %10s %10s\n", "name", "tid", "user",
+			"kernel", "vol", "invol", "wait us", "max us");
+	for (int i = 0; i < SCHED_REPORT_MAX; i++) {
+		const struct sched_report *r = &sched_reports[i];
+
+		if (r->stats.runq_wait_ns == 0)
+			continue;
+		printf ("  %-16s %5d %8lld %8lld %8lld %8lld %10llu %10llu\n",
+				r->name, r->tid, r->stats.user_ticks, r->stats.kernel_ticks,
+				r->stats.voluntary_switches, r->stats.involuntary_switches,
+				r->stats.runq_wait_ns / 1000, r->stats.runq_wait_max_ns / 1000);
+	}
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable ();
+	int recent_cpu_100 = fp_to_int_round (fp_mul_int (thread_current ()->recent_cpu, 100));
+	intr_set_level (old_level);
+	return recent_cpu_100;
+}
+
+/* MLFQS bookkeeping for timer tick TICK, called with the thread
+   T that ran during it.  Charges the tick to T, does the
+   once-a-second update, and recomputes T's priority every
+   PRI_RECALC_TICKS ticks.  Only T's priority can change between
+   seconds, since no other thread accumulates recent_cpu. */
+static void
+mlfqs_tick (struct thread *t, int64_t tick) {
+	ASSERT (intr_context ());
+
+	if (!is_idle_thread (t))
+		t->recent_cpu = fp_add_int (t->recent_cpu, 1); // 실행 중인 스레드만 recent_cpu가 증가한다.
+
+	if (tick % TIMER_FREQ == 0 && t->cpu == &cpus[0]) // 매초 갱신은 시각을 세는 BSP만 한다.
+		mlfqs_update_second (t);
+	else if (tick % PRI_RECALC_TICKS == 0 && !is_idle_thread (t)) {
+		mlfqs_catch_up (t); // 다른 CPU에서 실행 중이었다면 매초 갱신을 받지 못했다.
+		t->priority = mlfqs_priority (t);
+	}
+}
+
+/* Once-a-second MLFQS update: recomputes load_avg, records this
+   second's recent_cpu decay, and applies it to the running thread
+   T and to every ready thread, moving ready threads to the queue
+   for their new priority.  Blocked threads catch up later, in
+   thread_unblock(). */
+static void
+mlfqs_update_second (struct thread *t) {
+	int ready_threads = ready_thread_cnt () + (is_idle_thread (t) ? 0 : 1);
+	fixed_t twice_load;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (int i = 0; i < cpu_cnt; i++) // 다른 CPU에서 실행 중인 스레드도 센다.
+		if (cpus[i].online && &cpus[i] != t->cpu && cpus[i].curr != cpus[i].idle_thread)
+			ready_threads++;
+
+	/* load_avg = (59/60) * load_avg + (1/60) * ready_threads */
+	load_avg = fp_add (fp_div_int (fp_mul_int (load_avg, 59), 60),
+			fp_div_int (int_to_fp (ready_threads), 60));
+
+	/* decay = (2 * load_avg) / (2 * load_avg + 1) */
+	twice_load = fp_mul_int (load_avg, 2);
+	decay_history[(mlfqs_seconds + 1) % DECAY_HISTORY] =
+		fp_div (twice_load, fp_add_int (twice_load, 1));
+	mlfqs_seconds++; // 다른 CPU의 mlfqs_catch_up()이 새 decay를 먼저 보도록 나중에 센다.
+
+	if (!is_idle_thread (t)) {
+		mlfqs_catch_up (t);
+		t->priority = mlfqs_priority (t);
+	}
+
+	/* ready 스레드를 우선순위가 높은 순서대로 모두 꺼냈다가, 갱신 후 다시 넣는다.
+	   같은 우선순위 안에서의 FIFO 순서는 유지된다. */
+	for (int i = 0; i < cpu_cnt; i++) {
+		struct runqueue *rq = &cpus[i].rq;
+		struct list requeue;
+
+		if (!cpus[i].online)
+			continue;
+		spinlock_acquire (&rq->lock);
+		list_init (&requeue);
+		while (rq->bitmap != 0)
+			list_push_back (&requeue, &ready_queue_pop (rq)->elem);
+		while (!list_empty (&requeue)) {
+			struct thread *r = list_entry (list_pop_front (&requeue), struct thread, elem);
+			mlfqs_catch_up (r);
+			r->priority = mlfqs_priority (r);
+			ready_queue_push (rq, r);
+		}
+		spinlock_release (&rq->lock, INTR_OFF);
+	}
+}
+
+/* Applies to T's recent_cpu every once-a-second decay that it has
+   not seen yet:
+     recent_cpu = decay * recent_cpu + nice */
+static void
+mlfqs_catch_up (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (mlfqs_seconds - t->recent_cpu_sec > DECAY_HISTORY)
+		t->recent_cpu_sec = mlfqs_seconds - DECAY_HISTORY;
+
+	while (t->recent_cpu_sec < mlfqs_seconds) {
+		fixed_t decay = decay_history[++t->recent_cpu_sec % DECAY_HISTORY];
+		t->recent_cpu = fp_add_int (fp_mul (decay, t->recent_cpu), t->nice);
+	}
+}
+
+/* Returns T's MLFQS priority:
+     priority = PRI_MAX - (recent_cpu / 4) - (nice * 2)
+   clamped to PRI_MIN..PRI_MAX. */
+static int
+mlfqs_priority (struct thread *t) {
+	int priority = PRI_MAX - fp_to_int (fp_div_int (t->recent_cpu, 4)) - t->nice * 2;
+
+	if (priority < PRI_MIN)
+		return PRI_MIN;
+	if (priority > PRI_MAX)
+		return PRI_MAX;
+	return priority;
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -482,18 +1060,26 @@ thread_get_recent_cpu (void) {
    to it to enable thread_start() to continue, and immediately
    blocks.  After that, the idle thread never appears in the
    ready list.  It is returned by next_thread_to_run() as a
-   special case when the ready list is empty. */
+   special case when the ready list is empty.
+
+   An application processor's idle thread is already running when
+   it gets here, from thread_start_ap(), with a null IDLE_STARTED. */
 static void
 idle (void *idle_started_ UNUSED) {
 	struct semaphore *idle_started = idle_started_;
 
-	idle_thread = thread_current ();
-	sema_up (idle_started);
+	this_cpu ()->idle_thread = thread_current ();
+	if (idle_started != NULL)
+		sema_up (idle_started);
 
 	for (;;) {
 		/* Let someone else run. */
 		intr_disable ();
+		timer_idle_exit (); // 다른 인터럽트로 깨어났다면 주기적인 틱을 되살린다.
 		thread_block ();
+		if (palloc_idle ()) // 빈 시간에 페이지를 0으로 채우는 스레드를 먼저 돌린다.
+			continue;
+		timer_idle_enter (); // 다음 할 일이 있을 때까지 틱을 멈춘다.
 
 		/* Re-enable interrupts and wait for the next one.
 
@@ -516,6 +1102,7 @@ static void
 kernel_thread (thread_func *function, void *aux) {
 	ASSERT (function != NULL);
 
+	finish_switch ();
 	intr_enable ();       /* The scheduler runs with interrupts off. */
 	function (aux);       /* Execute the thread function. */
 	thread_exit ();       /* If function() returns, kill the thread. */
@@ -539,7 +1126,11 @@ init_thread (struct thread *t, const char *name, int priority) {
 	/*------------------------- [P1] Priority Scheduling --------------------------*/
 	t->priority_base = priority; // 초기 priority 상태를 확인한다.
 	t->wait_on_lock = NULL; // 스레드 생성시에는 기다리는 락이 없으니 NULL값으로 설정한다.
-	list_init (&t->donations); // donations 초기화
+	heap_init (&t->held_locks, cmp_lock_priority, NULL); // 잡고 있는 락 힙 초기화
+	/*------------------------- [P1] Advanced Scheduler --------------------------*/
+	t->nice = NICE_DEFAULT;
+	t->recent_cpu = int_to_fp (0);
+	t->recent_cpu_sec = mlfqs_seconds;
 	t->magic = THREAD_MAGIC;
 
 /*------------------------- [P2] System Call --------------------------*/
@@ -560,11 +1151,185 @@ init_thread (struct thread *t, const char *name, int priority) {
    idle_thread. */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list)){
-		return idle_thread;
-	}
+	struct cpu *c = this_cpu ();
+	struct thread *next;
+
+	if (c->rq.bitmap == 0)
+		steal_work (c); // 할 일이 없으면 idle로 가기 전에 가장 바쁜 CPU에서 일을 훔쳐온다.
+
+	spinlock_acquire (&c->rq.lock);
+	if (c->rq.bitmap == 0)
+		next = c->idle_thread;
 	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+		next = ready_queue_pop (&c->rq);
+	spinlock_release (&c->rq.lock, INTR_OFF);
+	return next;
+}
+
+/*------------------------- [P1] Priority Scheduling - O(1) Run Queue --------------------------*/
+/* Initializes RQ as an empty run queue. */
+static void
+runqueue_init (struct runqueue *rq) {
+	spinlock_init (&rq->lock);
+	for (int pri = PRI_MIN; pri <= PRI_MAX; pri++)
+		list_init (&rq->queues[pri]); // 우선순위별 ready 큐를 초기화한다.
+	rq->bitmap = 0;
+	rq->cnt = 0;
+}
+
+/* Appends T to the queue for its priority in RQ.
+   RQ's lock must be held. */
+static void
+ready_queue_push (struct runqueue *rq, struct thread *t) {
+	ASSERT (spinlock_held_by_current_cpu (&rq->lock));
+
+	if (t->status != THREAD_READY) // 다른 CPU로 옮겨질 때는 처음 들어온 시각을 유지한다.
+		t->ready_since = timer_ns ();
+	list_push_back (&rq->queues[t->priority], &t->elem);
+	rq->cnt++;
+	rq->bitmap |= 1ULL << t->priority; // 해당 우선순위 큐가 비어있지 않음을 표시한다.
+}
+
+/* Removes T from the queue for its priority in RQ.
+   RQ's lock must be held. */
+static void
+ready_queue_remove (struct runqueue *rq, struct thread *t) {
+	ASSERT (spinlock_held_by_current_cpu (&rq->lock));
+	ASSERT (t->status == THREAD_READY);
+
+	list_remove (&t->elem);
+	rq->cnt--;
+	if (list_empty (&rq->queues[t->priority]))
+		rq->bitmap &= ~(1ULL << t->priority);
+}
+
+/* Removes and returns the first thread of the highest-priority
+   non-empty queue in RQ.  RQ's lock must be held and RQ must not
+   be empty. */
+static struct thread *
+ready_queue_pop (struct runqueue *rq) {
+	int pri = ready_max_priority (rq);
+	struct thread *t;
+
+	ASSERT (spinlock_held_by_current_cpu (&rq->lock));
+	ASSERT (pri >= PRI_MIN);
+
+	t = list_entry (list_pop_front (&rq->queues[pri]), struct thread, elem);
+	rq->cnt--;
+	if (list_empty (&rq->queues[pri]))
+		rq->bitmap &= ~(1ULL << pri); // 큐가 비었으면 비트를 내린다.
+	return t;
+}
+
+/* Returns the highest priority among threads in RQ, or
+   PRI_MIN - 1 if RQ is empty. */
+// bsr 명령어 한 번으로 가장 높은 우선순위를 찾는다.
+static int
+ready_max_priority (struct runqueue *rq) {
+	uint64_t bitmap = rq->bitmap;
+
+	if (bitmap == 0)
+		return PRI_MIN - 1;
+	return 63 - __builtin_clzll (bitmap);
+}
+
+/* Returns true if a thread is waiting in this CPU's run queue.
+   Interrupts must be off. */
+bool
+thread_ready_waiting (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	return this_cpu ()->rq.bitmap != 0;
+}
+
+/* Returns the number of ready threads on all CPUs. */
+static int
+ready_thread_cnt (void) {
+	int cnt = 0;
+
+	for (int i = 0; i < cpu_cnt; i++)
+		if (cpus[i].online)
+			cnt += cpus[i].rq.cnt;
+	return cnt;
+}
+
+/*------------------------- [P1] SMP - Work Stealing --------------------------*/
+/* Locks and returns the run queue holding ready thread T.
+   Work stealing can move T to another CPU between reading
+   T->cpu and taking the lock, so check again once it is held. */
+static struct runqueue *
+lock_thread_runqueue (struct thread *t) {
+	for (;;) {
+		struct runqueue *rq = &t->cpu->rq;
+
+		spinlock_acquire (&rq->lock);
+		if (rq == &t->cpu->rq)
+			return rq;
+		spinlock_release (&rq->lock, INTR_OFF);
+	}
+}
+
+/* Called when C's run queue is empty.  Picks the online sibling
+   with the most ready threads and moves half of its
+   highest-priority band, taken from the back of the queue (the
+   threads that would have waited longest there), onto C's run
+   queue.  Threads keep their effective priority, including any
+   donation, and their `cpu' member is updated under both run
+   queue locks so that later donations find them.  Threads that
+   the victim has not finished switching away from are left
+   alone. */
+static void
+steal_work (struct cpu *c) {
+	struct cpu *victim = NULL;
+	struct cpu *first, *second;
+	int band, take, moved = 0;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	/* 락 없이 개수만 보고 가장 바쁜 CPU를 고른다. 아래에서 다시 확인한다. */
+	for (int i = 0; i < cpu_cnt; i++)
+		if (cpus[i].online && &cpus[i] != c && cpus[i].rq.cnt > 0
+				&& (victim == NULL || cpus[i].rq.cnt > victim->rq.cnt))
+			victim = &cpus[i];
+	if (victim == NULL)
+		return;
+
+	/* 교착 상태를 막기 위해 항상 id 순서대로 락을 잡는다. */
+	first = c->id < victim->id ? c : victim;
+	second = c->id < victim->id ? victim : c;
+	spinlock_acquire (&first->rq.lock);
+	spinlock_acquire (&second->rq.lock);
+
+	band = ready_max_priority (&victim->rq);
+	if (band >= PRI_MIN) {
+		struct list *q = &victim->rq.queues[band];
+		struct list_elem *e = list_rbegin (q);
+
+		take = (list_size (q) + 1) / 2;
+		while (moved < take && e != list_rend (q)) {
+			struct thread *t = list_entry (e, struct thread, elem);
+
+			e = list_prev (e);
+			if (t->on_cpu) // 아직 레지스터를 저장하는 중이다.
+				continue;
+			ready_queue_remove (&victim->rq, t);
+			t->cpu = c;
+			ready_queue_push (&c->rq, t);
+			moved++;
+		}
+		if (moved > 0) {
+			c->steals++;
+			c->migrations += moved;
+		}
+	}
+
+	spinlock_release (&second->rq.lock, INTR_OFF);
+	spinlock_release (&first->rq.lock, INTR_OFF);
+}
+
+/* Returns true if T is some CPU's idle thread. */
+static bool
+is_idle_thread (struct thread *t) {
+	return t->cpu != NULL && t == t->cpu->idle_thread;
 }
 
 /* Use iretq to launch the thread */
@@ -671,12 +1436,14 @@ thread_launch (struct thread *th) {
  * It's not safe to call printf() in the schedule(). */
 static void
 do_schedule(int status) {
+	struct list *dying = &this_cpu ()->dying;
+
 	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT (thread_current()->status == THREAD_RUNNING);
-	while (!list_empty (&destruction_req)) { // 좀비 스레드 제거
+	while (!list_empty (dying)) { // 좀비 스레드 제거
 		struct thread *victim =
-			list_entry (list_pop_front (&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
+			list_entry (list_pop_front (dying), struct thread, elem);
+		thread_cache_put (victim);
 	}
 	thread_current ()->status = status;
 	schedule ();
@@ -686,15 +1453,19 @@ do_schedule(int status) {
 static void schedule (void) {
 	struct thread *curr = running_thread ();
 	struct thread *next = next_thread_to_run ();
+	struct cpu *c = curr->cpu;
 
 	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT (curr->status != THREAD_RUNNING);
 	ASSERT (is_thread (next)); // 다음 스레드로 컨텍스트 스위칭
+	ASSERT (next == curr || !next->on_cpu);
 	/* Mark us as running. */
 	next->status = THREAD_RUNNING;
+	next->cpu = c; // 이 CPU에서 실행된다는 것을 기록한다. (this_cpu())
 
 	/* Start new time slice. */
-	thread_ticks = 0;
+	c->thread_ticks = 0;
+	c->yield_deferred = false; // 어차피 CPU를 넘기므로 미뤄둔 양보는 취소한다.
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -702,6 +1473,30 @@ static void schedule (void) {
 #endif
 
 	if (curr != next) {
+		c->switches++;
+		trace_event (TRACE_SWITCH, curr->tid, next->tid);
+
+		/* 유휴 중에 인터럽트로 깨어나 바로 다른 스레드로 넘어가는 경우에도
+		   주기적인 틱을 되살려야 새 스레드가 타임 슬라이스를 잃지 않는다. */
+		if (is_idle_thread (curr))
+			timer_idle_exit ();
+
+		/* 레디 상태로 밀려났으면 비자발적, 잠들거나 종료하면 자발적 스위치다. */
+		if (!is_idle_thread (curr)) {
+			if (curr->status == THREAD_READY) {
+				curr->stats.involuntary_switches++;
+				c->sched.involuntary_switches++;
+			} else {
+				curr->stats.voluntary_switches++;
+				c->sched.voluntary_switches++;
+			}
+		}
+		if (!is_idle_thread (next)) { // 레디 큐에서 기다린 시간을 기록한다.
+			uint64_t wait_ns = timer_ns () - next->ready_since;
+			sched_account_wait (&next->stats, wait_ns);
+			sched_account_wait (&c->sched, wait_ns);
+		}
+
 		/* If the thread we switched from is dying, destroy its struct
 		   thread. This must happen late so that thread_exit() doesn't
 		   pull out the rug under itself.
@@ -711,13 +1506,79 @@ static void schedule (void) {
 		   schedule(). */
 		if (curr && curr->status == THREAD_DYING && curr != initial_thread) {
 			ASSERT (curr != next);
-			list_push_back (&destruction_req, &curr->elem);
+			list_push_back (&c->dying, &curr->elem);
 		}
 
+		next->on_cpu = true;
+		c->curr = next;
+		c->switched_from = curr;
+
 		/* Before switching the thread, we first save the information
 		 * of current running. */
 		thread_launch (next);
+		finish_switch ();
+	}
+}
+
+/* Called by the thread that a context switch has just switched
+   to, before it does anything else: the thread the CPU switched
+   away from has its registers saved now, so other CPUs may steal
+   it. */
+static void
+finish_switch (void) {
+	struct cpu *c = this_cpu ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (c->switched_from != NULL) {
+		barrier (); // thread_launch()가 레지스터를 모두 저장한 뒤에 내려놓는다.
+		c->switched_from->on_cpu = false;
+		c->switched_from = NULL;
+	}
+}
+
+/* Handler for LAPIC_RESCHED_VEC, which thread_unblock() sends
+   after putting a thread on this CPU's run queue from another CPU.
+   An idle CPU wakes up from `hlt' and picks the thread up in
+   idle(); a busy one yields if the thread should run ahead. */
+static void
+resched_interrupt (struct intr_frame *f UNUSED) {
+	if (thread_get_priority () < ready_max_priority (&this_cpu ()->rq))
+		intr_yield_on_return ();
+}
+
+/*------------------------- [P1] Thread Cache --------------------------*/
+/* 스레드 페이지를 하나 가져온다. 캐시에 재사용할 페이지가 있으면 그것을,
+   없으면 palloc에서 새로 받는다. struct thread는 init_thread()에서
+   초기화되므로 페이지 전체를 0으로 채울 필요는 없다. */
+static struct thread *
+thread_cache_get (void) {
+	struct thread *t = NULL;
+	enum intr_level old_level = spinlock_acquire (&thread_cache_lock);
+	if (!list_empty (&thread_cache)) {
+		t = list_entry (list_pop_front (&thread_cache), struct thread, elem);
+		thread_cache_cnt--;
+	}
+	spinlock_release (&thread_cache_lock, old_level);
+
+	if (t == NULL)
+		t = palloc_get_page (0);
+	return t;
+}
+
+/* 종료된 스레드 T의 페이지를 캐시에 넣는다. 캐시가 가득 찼으면 반환한다. */
+static void
+thread_cache_put (struct thread *t) {
+	enum intr_level old_level = spinlock_acquire (&thread_cache_lock);
+	if (thread_cache_cnt < THREAD_CACHE_MAX) {
+		list_push_front (&thread_cache, &t->elem); // 최근에 쓴 페이지를 먼저 재사용한다. (캐시 친화적)
+		thread_cache_cnt++;
+		t = NULL;
 	}
+	spinlock_release (&thread_cache_lock, old_level);
+
+	if (t != NULL)
+		palloc_free_page (t);
 }
 
 /* Returns a tid to use for a new thread. */
@@ -0,0 +1,124 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/scratch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/*------------------------- [P1] Event Tracing --------------------------*/
+/* Pages of events per CPU, and the events that fit in them.
+   TRACE_EVENTS must be a power of 2. */
+#define TRACE_PAGES 32
+#define TRACE_EVENTS (TRACE_PAGES * PGSIZE / sizeof (struct trace_event))
+
+/* Magic number and version at the start of a dump. */
+#define TRACE_MAGIC 0x43525450          /* "PTRC". */
+#define TRACE_VERSION 1
+
+/* A CPU's ring buffer.  Only its own CPU writes to it, with
+   interrupts off, so it needs no lock. */
+struct trace_buf {
+	struct trace_event *events;         /* TRACE_EVENTS slots. */
+	uint64_t head;                      /* # of events ever recorded. */
+};
+
+/* Header of a dump.  Each CPU's events follow, oldest first. */
+struct trace_header {
+	uint32_t magic;                     /* TRACE_MAGIC. */
+	uint16_t version;                   /* TRACE_VERSION. */
+	uint16_t event_size;                /* sizeof (struct trace_event). */
+	uint32_t cpu_cnt;                   /* # of CPUs dumped. */
+	uint32_t counts[NCPU_MAX];          /* # of events dumped per CPU. */
+	uint64_t lost[NCPU_MAX];            /* # of events overwritten per CPU. */
+};
+
+bool trace_enabled;
+
+static struct trace_buf bufs[NCPU_MAX];
+
+/* Allocates a ring buffer for every CPU, if tracing is enabled. */
+void
+trace_init (void) {
+	if (!trace_enabled)
+		return;
+
+	for (int i = 0; i < cpu_cnt; i++) {
+		bufs[i].events = palloc_get_multiple (PAL_ZERO, TRACE_PAGES);
+		if (bufs[i].events == NULL) {
+			printf ("trace: out of memory, tracing disabled\n");
+			trace_enabled = false;
+			return;
+		}
+	}
+}
+
+/* Records an event of TYPE with arguments A and B in the current
+   CPU's ring buffer. */
+void
+trace_record (enum trace_type type, uint64_t a, uint64_t b) {
+	enum intr_level old_level = intr_disable ();
+	/* schedule() 도중에도 불리므로 thread_current()의 검사를 거치지 않는다. */
+	struct thread *t = (struct thread *) pg_round_down (rrsp ());
+	struct trace_buf *buf = t->cpu != NULL ? &bufs[t->cpu->id] : NULL;
+
+	if (buf != NULL && buf->events != NULL) {
+		struct trace_event *e = &buf->events[buf->head++ & (TRACE_EVENTS - 1)];
+
+		e->ns = timer_ns ();
+		e->type = type;
+		e->cpu = t->cpu->id;
+		e->tid = t->tid;
+		e->a = a;
+		e->b = b;
+	}
+	intr_set_level (old_level);
+}
+
+/* The "tracedump" action: writes the ring buffers to the scratch
+   disk.  Stops tracing first so that the dump does not record
+   itself. */
+void
+trace_dump (char **argv UNUSED) {
+	static struct trace_header hdr;
+	struct scratch_writer w;
+	size_t size;
+
+	if (!trace_enabled) {
+		printf ("tracedump: tracing is off (use -trace)\n");
+		return;
+	}
+	trace_enabled = false;
+
+	memset (&hdr, 0, sizeof hdr);
+	hdr.magic = TRACE_MAGIC;
+	hdr.version = TRACE_VERSION;
+	hdr.event_size = sizeof (struct trace_event);
+	hdr.cpu_cnt = cpu_cnt;
+	size = sizeof hdr;
+	for (int i = 0; i < cpu_cnt; i++) {
+		uint64_t head = bufs[i].head;
+
+		hdr.counts[i] = head < TRACE_EVENTS ? head : TRACE_EVENTS;
+		hdr.lost[i] = head - hdr.counts[i];
+		size += hdr.counts[i] * sizeof (struct trace_event);
+	}
+	printf ("Dumping %zu bytes of trace to the scratch disk...\n", size);
+
+	/* 헤더 뒤에 각 CPU의 이벤트를 오래된 것부터 이어 쓴다. */
+	scratch_begin (&w, size);
+	scratch_write (&w, &hdr, sizeof hdr);
+	for (int i = 0; i < cpu_cnt; i++) {
+		uint64_t first = bufs[i].head - hdr.counts[i];
+
+		for (uint64_t n = first; n < bufs[i].head; n++)
+			scratch_write (&w, &bufs[i].events[n & (TRACE_EVENTS - 1)],
+					sizeof (struct trace_event));
+	}
+	scratch_end (&w);
+}
@@ -4,6 +4,7 @@
 #include "userprog/gdt.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "intrinsic.h"
 
 /* Number of page faults processed. */
@@ -139,6 +140,7 @@ page_fault (struct intr_frame *f) {
 	not_present = (f->error_code & PF_P) == 0;
 	write = (f->error_code & PF_W) != 0;
 	user = (f->error_code & PF_U) != 0;
+	trace_event (TRACE_PAGE_FAULT, (uintptr_t) fault_addr, f->error_code);
 
 #ifdef VM
 	/* For project 3 and later. */
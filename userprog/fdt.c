@@ -0,0 +1,189 @@
+#include "userprog/fdt.h"
+#include <debug.h>
+#include <round.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+
+/* Number of 64-bit words in the USED bitmap of a SIZE-entry table. */
+#define FDT_WORDS(SIZE) DIV_ROUND_UP (SIZE, 64)
+
+/* FULL has one bit per word of USED. */
+#if FDT_WORDS (FDCOUNT_LIMIT) > 64
+#error FDCOUNT_LIMIT too large
+#endif
+
+static bool fdt_grow (struct fdtable *);
+static void fdt_mark (struct fdtable *, int fd);
+static void fdt_unmark (struct fdtable *, int fd);
+
+/* Initializes FDT as an empty table.  No memory is allocated until
+   the first file is added. */
+void
+fdt_init (struct fdtable *fdt) {
+	fdt->files = NULL;
+	fdt->used = NULL;
+	fdt->full = 0;
+	fdt->size = 0;
+	fdt->cnt = 0;
+}
+
+/* Adds F to FDT at the lowest free fd and returns the fd.
+   Returns -1 if FDT has FDCOUNT_LIMIT entries in use or if memory
+   for a larger table cannot be allocated. */
+int
+fdt_add (struct fdtable *fdt, struct file *f) {
+	ASSERT (f != NULL);
+
+	for (;;) {
+		// 빈 자리가 남아 있는 가장 낮은 word에서 가장 낮은 빈 비트를 찾는다.
+		int word = __builtin_ctzll (~fdt->full);
+		if (word < FDT_WORDS (fdt->size)) {
+			int fd = word * 64 + __builtin_ctzll (~fdt->used[word]);
+			if (fd < fdt->size) {
+				fdt->files[fd] = f;
+				fdt_mark (fdt, fd);
+				fdt->cnt++;
+				return fd;
+			}
+		}
+		// 테이블이 가득 찼으므로 두 배로 늘린다.
+		if (!fdt_grow (fdt))
+			return -1;
+	}
+}
+
+/* Returns the file open as FD in FDT, or NULL if FD is not open. */
+struct file *
+fdt_get (struct fdtable *fdt, int fd) {
+	if (fd < 0 || fd >= fdt->size)
+		return NULL;
+	return fdt->files[fd];
+}
+
+/* Removes FD from FDT and returns the file that was open as FD, or
+   NULL if FD was not open.  The file is not closed. */
+struct file *
+fdt_remove (struct fdtable *fdt, int fd) {
+	struct file *f = fdt_get (fdt, fd);
+	if (f == NULL)
+		return NULL;
+
+	fdt->files[fd] = NULL;
+	fdt_unmark (fdt, fd);
+	fdt->cnt--;
+	return f;
+}
+
+/* Makes DST, which must be empty, a copy of SRC, duplicating each
+   open file with file_duplicate().  Only open fds are visited, so
+   the cost depends on the number of open files, not on the size of
+   the table.  Returns false if memory runs out; files duplicated so
+   far stay in DST and are released by fdt_destroy(). */
+bool
+fdt_duplicate (struct fdtable *dst, struct fdtable *src) {
+	ASSERT (dst->size == 0);
+
+	if (src->size == 0)
+		return true;
+
+	dst->files = calloc (src->size, sizeof *dst->files);
+	dst->used = calloc (FDT_WORDS (src->size), sizeof *dst->used);
+	if (dst->files == NULL || dst->used == NULL) {
+		free (dst->files);
+		free (dst->used);
+		fdt_init (dst);
+		return false;
+	}
+	dst->size = src->size;
+	fdt_mark (dst, 0); // stdin
+	fdt_mark (dst, 1); // stdout
+
+	for (int word = 0; word < FDT_WORDS (src->size); word++) {
+		uint64_t bits = src->used[word];
+		while (bits != 0) {
+			int fd = word * 64 + __builtin_ctzll (bits);
+			bits &= bits - 1;
+			if (src->files[fd] == NULL) // stdin, stdout
+				continue;
+
+			struct file *f = file_duplicate (src->files[fd]);
+			if (f == NULL)
+				return false;
+			dst->files[fd] = f;
+			fdt_mark (dst, fd);
+			dst->cnt++;
+		}
+	}
+	return true;
+}
+
+/* Closes every file open in FDT and frees its memory, leaving FDT
+   empty. */
+void
+fdt_destroy (struct fdtable *fdt) {
+	for (int word = 0; word < FDT_WORDS (fdt->size); word++) {
+		uint64_t bits = fdt->used[word];
+		while (bits != 0) {
+			int fd = word * 64 + __builtin_ctzll (bits);
+			bits &= bits - 1;
+			file_close (fdt->files[fd]);
+		}
+	}
+	free (fdt->files);
+	free (fdt->used);
+	fdt_init (fdt);
+}
+
+/* Doubles the size of FDT, or allocates it with FDT_INIT_SIZE
+   entries if it is empty.  Returns false if FDT already has
+   FDCOUNT_LIMIT entries or if memory runs out. */
+static bool
+fdt_grow (struct fdtable *fdt) {
+	int size = fdt->size == 0 ? FDT_INIT_SIZE : fdt->size * 2;
+	if (size > FDCOUNT_LIMIT)
+		size = FDCOUNT_LIMIT;
+	if (size <= fdt->size)
+		return false;
+
+	struct file **files = calloc (size, sizeof *files);
+	uint64_t *used = calloc (FDT_WORDS (size), sizeof *used);
+	if (files == NULL || used == NULL) {
+		free (files);
+		free (used);
+		return false;
+	}
+
+	int old_size = fdt->size;
+	if (old_size != 0) { // 기존 엔트리와 비트맵을 옮긴다.
+		memcpy (files, fdt->files, old_size * sizeof *files);
+		memcpy (used, fdt->used, FDT_WORDS (old_size) * sizeof *used);
+		free (fdt->files);
+		free (fdt->used);
+	}
+	fdt->files = files;
+	fdt->used = used;
+	fdt->size = size;
+	if (old_size == 0) {
+		fdt_mark (fdt, 0); // stdin
+		fdt_mark (fdt, 1); // stdout
+	}
+	return true;
+}
+
+/* Marks FD used in FDT. */
+static void
+fdt_mark (struct fdtable *fdt, int fd) {
+	int word = fd / 64;
+	fdt->used[word] |= (uint64_t) 1 << (fd % 64);
+	if (fdt->used[word] == UINT64_MAX)
+		fdt->full |= (uint64_t) 1 << word;
+}
+
+/* Marks FD free in FDT. */
+static void
+fdt_unmark (struct fdtable *fdt, int fd) {
+	int word = fd / 64;
+	fdt->used[word] &= ~((uint64_t) 1 << (fd % 64));
+	fdt->full &= ~((uint64_t) 1 << word);
+}
@@ -0,0 +1,110 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <list.h>
+#include <stdint.h>
+#include "threads/spinlock.h"
+#include "threads/thread.h"
+
+/* Sleepers are spread over a fixed number of buckets, each with its
+   own spin lock, so unrelated futexes rarely share a lock. */
+#define FUTEX_BUCKETS 64
+
+struct futex_bucket {
+	struct spinlock spin;               /* Protects WAITERS. */
+	struct list waiters;                /* struct futex_waiter, by priority. */
+};
+
+/* A thread sleeping in futex_wait().  Lives on its stack. */
+struct futex_waiter {
+	const int *kaddr;                   /* Futex word slept on. */
+	struct thread *thread;              /* Sleeping thread. */
+	struct list_elem elem;              /* Element in bucket's waiters. */
+};
+
+static struct futex_bucket buckets[FUTEX_BUCKETS];
+
+static struct futex_bucket *bucket_of (const int *kaddr);
+static bool cmp_waiter_priority (const struct list_elem *, const struct list_elem *, void *aux);
+
+/* Initializes the futex wait queues. */
+void
+futex_init (void) {
+	for (int i = 0; i < FUTEX_BUCKETS; i++) {
+		spinlock_init (&buckets[i].spin);
+		list_init (&buckets[i].waiters);
+	}
+}
+
+/* Sleeps until futex_wake() is called on KADDR, if the word at
+   KADDR, a kernel address, still holds VAL.  Returns 0 after
+   sleeping, or -1 at once if the word holds another value.
+
+   The word is checked under the bucket's lock, which futex_wake()
+   also takes, so a waker that changes the word before calling
+   futex_wake() cannot slip in between the check and the sleep. */
+int
+futex_wait (const int *kaddr, int val) {
+	struct futex_bucket *b = bucket_of (kaddr);
+	struct futex_waiter waiter;
+	enum intr_level old_level;
+
+	ASSERT (!intr_context ());
+
+	old_level = spinlock_acquire (&b->spin);
+	if (*(volatile const int *) kaddr != val) {
+		spinlock_release (&b->spin, old_level);
+		return -1;
+	}
+
+	waiter.kaddr = kaddr;
+	waiter.thread = thread_current ();
+	list_insert_ordered (&b->waiters, &waiter.elem, cmp_waiter_priority, NULL);
+	spinlock_release (&b->spin, INTR_OFF); // block 될 때까지 인터럽트는 꺼둔다.
+	thread_block ();
+	intr_set_level (old_level);
+	return 0;
+}
+
+/* Wakes up to CNT threads sleeping on KADDR, a kernel address,
+   highest priority first.  Returns the number of threads woken. */
+int
+futex_wake (const int *kaddr, int cnt) {
+	struct futex_bucket *b = bucket_of (kaddr);
+	int woken = 0, max_priority = PRI_MIN - 1;
+	enum intr_level old_level;
+	struct list_elem *e;
+
+	old_level = spinlock_acquire (&b->spin);
+	for (e = list_begin (&b->waiters); e != list_end (&b->waiters) && woken < cnt; ) {
+		struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+		if (w->kaddr != kaddr) {
+			e = list_next (e);
+			continue;
+		}
+		e = list_remove (e); // unblock 이후에는 W가 사라질 수 있으므로 먼저 뺀다.
+		if (w->thread->priority > max_priority)
+			max_priority = w->thread->priority;
+		thread_unblock (w->thread);
+		woken++;
+	}
+	spinlock_release (&b->spin, INTR_OFF); // 양보하기 전에 스핀락을 놓는다.
+
+	if (thread_get_priority () < max_priority)
+		thread_yield ();
+	intr_set_level (old_level);
+	return woken;
+}
+
+/* Returns the bucket for futex word KADDR. */
+static struct futex_bucket *
+bucket_of (const int *kaddr) {
+	uintptr_t key = (uintptr_t) kaddr / sizeof (int);
+	return &buckets[(key ^ key >> 6 ^ key >> 12) % FUTEX_BUCKETS];
+}
+
+// bucket의 waiters를 우선순위 내림차순으로 유지한다.
+static bool
+cmp_waiter_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) {
+	return list_entry (a, struct futex_waiter, elem)->thread->priority
+		> list_entry (b, struct futex_waiter, elem)->thread->priority;
+}
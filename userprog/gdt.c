@@ -1,6 +1,8 @@
 #include "userprog/gdt.h"
 #include <debug.h>
+#include <string.h>
 #include "userprog/tss.h"
+#include "threads/cpu.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
@@ -72,18 +74,25 @@ static struct segment_desc gdt[SEL_CNT] = {
 	[7] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
 };
 
-struct desc_ptr gdt_ds = {
-	.size = sizeof(gdt) - 1,
-	.address = (uint64_t) gdt
-};
+/* Each CPU's copy of GDT, by CPU id.  A TSS descriptor is marked
+   busy once loaded, and each CPU has a TSS of its own. */
+static struct segment_desc gdts[NCPU_MAX][SEL_CNT];
 
-/* Sets up a proper GDT.  The bootstrap loader's GDT didn't
-   include user-mode selectors or a TSS, but we need both now. */
+/* Sets up a proper GDT for the running CPU.  The bootstrap
+   loader's GDT didn't include user-mode selectors or a TSS, but we
+   need both now.  Must be called after tss_init(). */
 void
 gdt_init (void) {
+	struct segment_desc *gdt_cpu = gdts[this_cpu ()->id];
+	struct desc_ptr gdt_ds = {
+		.size = sizeof(gdt) - 1,
+		.address = (uint64_t) gdt_cpu
+	};
+
 	/* Initialize GDT. */
+	memcpy (gdt_cpu, gdt, sizeof gdt);
 	struct segment_descriptor64 *tss_desc =
-		(struct segment_descriptor64 *) &gdt[SEL_TSS >> 3];
+		(struct segment_descriptor64 *) &gdt_cpu[SEL_TSS >> 3];
 	struct task_state *tss = tss_get ();
 
 	*tss_desc = (struct segment_descriptor64) {
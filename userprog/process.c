@@ -7,6 +7,7 @@
 #include <string.h>
 #include "userprog/gdt.h"
 #include "userprog/tss.h"
+#include "userprog/vdso.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
@@ -14,6 +15,7 @@
 #include "threads/init.h"
 #include "threads/interrupt.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
@@ -191,6 +193,8 @@ __do_fork (void *aux) {
 		goto error;
 
 	process_activate (current);
+	if (!vdso_map (current))
+		goto error;
 #ifdef VM
 	supplemental_page_table_init (&current->spt);
 	if (!supplemental_page_table_copy (&current->spt, &parent->spt))
@@ -210,18 +214,13 @@ __do_fork (void *aux) {
 	 * 파일 객체를 복제하려면 'file_duplicate'를 사용하라.
 	 * 이 함수가 부모의 리소스를 성공적으로 복제할 때까지 부모 프로세스는 fork로 부터 리턴할 수 없다.
 	*/
-	if (parent->next_fd == FDCOUNT_LIMIT)
+	if (parent->fdt.cnt == FDCOUNT_LIMIT - 2) // 부모의 fdt가 가득 찬 경우 (stdin, stdout 제외)
 		goto error;
 
-	// 부모의 fdt를 자식의 fdt로 복사한다.
-	for (int fd = 2; fd < FDCOUNT_LIMIT; fd++) {
-		struct file *file = parent->fdt[fd];
-		if (file == NULL) // fd엔트리가 없는 상태에는 그냥 건너뛴다.
-			continue;
-		current->fdt[fd] = file_duplicate (file);
-	}
+	// 부모의 fdt를 자식의 fdt로 복사한다. 열려 있는 fd만 복제한다.
+	if (!fdt_duplicate (&current->fdt, &parent->fdt))
+		goto error;
 
-	current->next_fd = parent->next_fd; // 부모의 next_fd를 자식의 next_fd로 옮겨준다.
 	sema_up(&current->fork_sema); // fork가 정상적으로 완료되었으므로 현재 wait중인 parent를 다시 실행 가능 상태로 만든다. 
 
 	/* Finally, switch to the newly created process. */
@@ -315,7 +314,9 @@ process_wait (tid_t child_tid UNUSED) {
 	// 컨텍스트 스위칭 발생
 
 	int exit_status = child->exit_status; // 자식으로 부터 종료인자를 전달 받고 리스트에서 삭제한다.
+	enum intr_level old_level = spinlock_acquire (&thread_child_lock);
 	list_remove(&child->child_elem);
+	spinlock_release (&thread_child_lock, old_level);
 	
 	// sema_up(&child->free_sema); // 자식 프로세스 종료 상태를 받은 후 자식 프로세스를 종료하게 한다.
 
@@ -331,16 +332,31 @@ process_exit (void) {
 	 * TODO: project2/process_termination.html).
 	 * TODO: We recommend you to implement process resource cleanup here. */
 	
-	for (int i = 0; i < FDCOUNT_LIMIT; i++) // 프로세스 종료 시, 해당 프로세스의 fdt의 모든 값을 0으로 만들어준다.
-		close(i);
-	palloc_free_multiple(curr->fdt, FDT_PAGES); // fd table 메모리 해제
+	// 유저 프로세스였는지, 커널 스레드였는지 (fork에 실패한 자식도 부모가 exit_status를 읽는다)
+	bool is_process = curr->pml4 != NULL || curr->exit_status == TID_ERROR;
+
+	fdt_destroy(&curr->fdt); // 프로세스 종료 시, 열려 있는 파일을 모두 닫고 fd table 메모리를 해제한다.
 
 	file_close(curr->running); // 현재 프로세스가 실행중인 파일을 종료한다.	
 
 	process_cleanup ();
 
+	/* 스레드 페이지는 종료 직후 다른 스레드에 재사용되므로 (thread_create),
+	 * 자식 리스트와 부모의 자식 리스트에 dangling 포인터를 남기지 않는다. */
+	enum intr_level old_level = spinlock_acquire (&thread_child_lock);
+	while (!list_empty(&curr->child_list)) { // 남은 자식들을 리스트에서 떼어낸다.
+		struct list_elem *e = list_pop_front(&curr->child_list);
+		e->prev = e->next = NULL;
+	}
+	if (!is_process && curr->child_elem.next != NULL) { // 커널 스레드는 wait 대상이 아니므로 스스로 빠진다.
+		list_remove(&curr->child_elem);
+		curr->child_elem.prev = curr->child_elem.next = NULL;
+	}
+	spinlock_release (&thread_child_lock, old_level);
+
 	sema_up(&curr->wait_sema); // 부모 프로세스가 자식 프로세스의 종료상태를 확인하게 한다.
-	thread_sleep(500);
+	if (is_process)
+		thread_sleep(500);
 	// sema_down(&curr->free_sema); // 부모 프로세스가 자식 프로세스의 종료 상태를 받을때 까지 대기한다. 
 }
 
@@ -354,6 +370,8 @@ process_cleanup (void) {
 		supplemental_page_table_kill (&curr->spt);
 #endif
 
+	vdso_unmap (curr); // pml4_destroy()가 공유 페이지까지 해제하지 않도록 먼저 떼어낸다.
+
 	uint64_t *pml4;
 	/* Destroy the current process's page directory and switch back
 	 * to the kernel-only page directory. */
@@ -381,6 +399,8 @@ process_activate (struct thread *next) {
 
 	/* Set thread's kernel stack for use in processing interrupts. */
 	tss_update (next);
+
+	vdso_activate (next);
 }
 
 /* We load ELF binaries.  The following definitions are taken
@@ -460,6 +480,8 @@ load (const char *file_name, struct intr_frame *if_) {
 	if (t->pml4 == NULL)
 		goto done;
 	process_activate (thread_current ());
+	if (!vdso_map (t)) // 시각, pid 등을 시스템 콜 없이 읽을 수 있는 페이지를 매핑한다.
+		goto done;
 
 	/* Open executable file. */
 	file = filesys_open (file_name);
@@ -802,7 +824,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 	
 		// 새 UNINIT 페이지를 만들어 현재 프로세스의 spt에 넣음
 		// 페이지에 해당하는 파일의 정보들을 segment_aux 구조체에 담아서 aux로 넘겨줌
-		struct segment_aux* segment_aux = (struct segment_aux *)malloc(sizeof(struct segment_aux));
+		struct segment_aux* segment_aux = kmem_cache_alloc(segment_aux_cache);
 		
 		segment_aux->file = file; // 세그먼트를 읽어올 파일
 		segment_aux->page_read_bytes = page_read_bytes; // 총 읽어올 바이트
@@ -906,13 +928,18 @@ static void argument_stack(int argc, char **argv, struct intr_frame *if_){
 struct thread *get_child_process(int pid){
 	struct thread *curr = thread_current();
 	struct list *child_list = &curr->child_list;
+	struct thread *child = NULL;
+	enum intr_level old_level = spinlock_acquire (&thread_child_lock); // 커널 스레드 자식은 다른 CPU에서 스스로 빠질 수 있다.
 
 	// 자식 리스트를 순회하면서 프로세스 디스크립터 검색
 	for (struct list_elem *e = list_begin(child_list); e != list_end(child_list); e = list_next(e))
 	{
 		struct thread *t = list_entry(e, struct thread, child_elem);
-		if (t->tid == pid) // 해당 pid가 존재하면 프로세스 디스크립터 리턴
-			return t;
+		if (t->tid == pid) { // 해당 pid가 존재하면 프로세스 디스크립터 리턴
+			child = t;
+			break;
+		}
 	}
-	return NULL; // 리스트에 존재하지 않으면 NULL
+	spinlock_release (&thread_child_lock, old_level);
+	return child; // 리스트에 존재하지 않으면 NULL
 }
@@ -1,10 +1,13 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "threads/loader.h"
 #include "userprog/gdt.h"
+#include "userprog/tss.h"
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "intrinsic.h"
 
@@ -16,6 +19,11 @@
 #include "lib/stdio.h" 			// predefined fd
 #include "threads/synch.h" 		// lock
 #include "vm/vm.h" 				// spt_find_page
+#include "userprog/futex.h" 		// futex_wait, futex_wake
+#include "devices/timer.h" 		// timer_ns
+#include "userprog/process.h" 	// get_child_process
+#include "threads/trace.h" 		// trace_event
+#include "userprog/vdso.h" 		// vdso_overlaps
 
 typedef int pid_t; // #include "lib/user/syscall.h" -> type conflict 발생으로 인한 재정의
 
@@ -44,6 +52,14 @@ void close (int fd);
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
 
+/*------------------------- [P2] Futex --------------------------*/
+int futex (int *uaddr, int op, int val);
+static const int *futex_kaddr (int *uaddr);
+
+/*------------------------- [P2] Clock --------------------------*/
+uint64_t clock_ns (void);
+int sched_stats (pid_t pid, struct sched_stats *stats);
+
 /*------------------------- [P2] System Call - help function --------------------------*/
 static int fdt_add_fd(struct file *f); 
 static struct file *fdt_get_file(int fd); 
@@ -69,9 +85,33 @@ static void check_buffer(void*, unsigned, bool);
 #define MSR_STAR 0xc0000081         /* Segment selector msr */
 #define MSR_LSTAR 0xc0000082        /* Long mode SYSCALL target */
 #define MSR_SYSCALL_MASK 0xc0000084 /* Mask for the eflags */
+#define MSR_KERNEL_GS_BASE 0xc0000102 /* GS base that swapgs swaps in */
+
+/* Per-CPU state that syscall_entry finds through the kernel GS
+ * base before it has a stack: room for the two user registers it
+ * needs as scratch, and the CPU's TSS, which holds its kernel
+ * stack pointer.  syscall-entry.S knows this layout. */
+struct syscall_cpu {
+	uint64_t rbx;
+	uint64_t r12;
+	struct task_state *tss;
+};
+
+static struct syscall_cpu syscall_cpus[NCPU_MAX];
 
 void
 syscall_init (void) {
+	syscall_init_cpu ();
+	futex_init ();
+}
+
+/* Makes the running CPU enter syscall_entry on `syscall'.  Called
+ * by syscall_init() on the bootstrap processor and by ap_main() on
+ * each application processor, after tss_init(). */
+void
+syscall_init_cpu (void) {
+	struct syscall_cpu *sc = &syscall_cpus[this_cpu ()->id];
+
 	write_msr(MSR_STAR, ((uint64_t)SEL_UCSEG - 0x10) << 48  |
 			((uint64_t)SEL_KCSEG) << 32);
 	write_msr(MSR_LSTAR, (uint64_t) syscall_entry);
@@ -81,9 +121,9 @@ syscall_init (void) {
 	 * mode stack. Therefore, we masked the FLAG_FL. */
 	write_msr(MSR_SYSCALL_MASK,
 			FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
-	
-	/*------------------------- [P2] System Call --------------------------*/	
-	lock_init(&filesys_lock); // 파일 읽고 쓰기에 필요한 락 초기화 _defined "userprog/syscall.h"
+
+	sc->tss = tss_get ();
+	write_msr(MSR_KERNEL_GS_BASE, (uint64_t) sc);
 }
 
 /* The main system call interface */
@@ -92,10 +132,12 @@ void
 syscall_handler (struct intr_frame *f UNUSED) {
 	// TODO: Your implementation goes here.
 	struct thread *curr = thread_current();
+	uint64_t syscall_nr = f->R.rax;
 	#ifdef VM
 		curr->rsp_stack = f->rsp;
     #endif
 
+	trace_event (TRACE_SYSCALL_ENTER, syscall_nr, f->R.rdi);
 	switch (f->R.rax) // 시스템 콜 번호에 따라 분기
 	{
 	case SYS_HALT:
@@ -149,10 +191,20 @@ syscall_handler (struct intr_frame *f UNUSED) {
 	case SYS_MUNMAP:
 		munmap(f->R.rdi);
 		break;
+	case SYS_FUTEX:
+		f->R.rax = futex ((int *) f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_CLOCK_NS:
+		f->R.rax = clock_ns ();
+		break;
+	case SYS_SCHED_STATS:
+		f->R.rax = sched_stats (f->R.rdi, (struct sched_stats *) f->R.rsi);
+		break;
 	default:
 		exit (-1);
 		break;
 	}
+	trace_event (TRACE_SYSCALL_EXIT, syscall_nr, f->R.rax);
 	// printf ("system call!\n");
 	// thread_exit ();
 }
@@ -261,7 +313,6 @@ remove(const char *file){
 int 
 open (const char *file){
 	check_address(file);
-	lock_acquire(&filesys_lock);
 	struct file *target_file = filesys_open(file);
 
 	if (target_file == NULL) {
@@ -273,7 +324,6 @@ open (const char *file){
 	if (fd == -1) {
 		file_close(target_file);
 	}
-	lock_release(&filesys_lock);
 	return fd;
 }
 
@@ -321,9 +371,7 @@ read(int fd, void *buffer, unsigned size) {
 	else{
 		struct file *file = fdt_get_file(fd);
 		if (file != NULL && fd != STDOUT_FILENO){ // STDOUT_FILENO 
-			lock_acquire(&filesys_lock); // 파일을 읽는 동안은 접근 못하게 락 걸어줌
-			read_bytes = file_read(file, buffer, size);
-			lock_release(&filesys_lock); // 락 해제
+			read_bytes = file_read(file, buffer, size); // 동기화는 inode의 reader-writer 락이 담당한다.
 		}
 	}
 	return read_bytes;
@@ -349,9 +397,7 @@ write (int fd, const void *buffer, unsigned size) {
 	else {
 		struct file *file = fdt_get_file(fd);
 		if (file != NULL && fd != STDIN_FILENO){ // STDIN_FILENO
-			lock_acquire(&filesys_lock); // 파일을 쓰는 동안은 접근 못하게 락 걸어줌
-			write_bytes = file_write(file, buffer, size);
-			lock_release(&filesys_lock); // 락 해제
+			write_bytes = file_write(file, buffer, size); // 동기화는 inode의 reader-writer 락이 담당한다.
 		}
 	}
 	return write_bytes;
@@ -398,7 +444,7 @@ void
 close (int fd){
 	struct file *target_file = fdt_get_file(fd);
 
-	if (fd <= STDOUT_FILENO || target_file == NULL || target_file <= 2)
+	if (fd <= STDOUT_FILENO || target_file == NULL)
 		return;
 	
 	fdt_remove_fd(fd); // fd table에서 해당 fd값을 제거한다.
@@ -427,13 +473,18 @@ void *mmap (void *addr, size_t length, int writable, int fd, off_t offset){
 	 * CASE 6. 읽으려는 파일의 길이가 0보다 작거나 같은 경우
 	 * CASE 7. STDIN, STDOUT 인 경우
 	 * CASE 8. 파일 객체가 존재하지 않는 경우
-	 * CASE 9. fd로 열린 파일의 길이가 0인 경우 */
+	 * CASE 9. fd로 열린 파일의 길이가 0인 경우
+	 * CASE 10. vDSO 페이지와 겹치는 경우 */
 
 	// CASE 1 - 6
     if (addr == NULL || is_kernel_vaddr(addr) || is_kernel_vaddr(pg_round_up(addr)) || pg_round_down(addr) != addr || spt_find_page(&thread_current()->spt, addr) \
 		|| offset > PGSIZE \
 		|| (long) length <= 0) // ? 형 변환 안하면 통과 못함 -> 엄청나게 큰 값이 아니라 음수야.
         return NULL;
+
+	// CASE 10 - vDSO 페이지는 SPT에 없어서 spt_find_page로 걸러지지 않는다.
+    if (vdso_overlaps (addr, length))
+        return NULL;
 		
 	/* mmap-kernel TC
 	 * kernel = (void *) 0x8004000000 - 0x1000;
@@ -460,6 +511,89 @@ void munmap (void *addr){
 }
 
 
+/*------------------------- [P2] Futex --------------------------*/
+/**
+ * @brief 유저 주소의 futex 워드에서 잠들거나, 잠든 스레드를 깨운다.
+ * @details 잠든 스레드는 워드의 물리 프레임(커널 주소)으로 구분하므로 @n
+ * 같은 프레임을 매핑한 프로세스끼리는 같은 대기 큐를 쓴다.
+ * @param uaddr 4바이트 정렬된 futex 워드의 유저 주소
+ * @param op FUTEX_WAIT 또는 FUTEX_WAKE
+ * @param val FUTEX_WAIT: 워드의 기대 값, FUTEX_WAKE: 깨울 최대 스레드 수
+ * @return int FUTEX_WAIT: 깨어나면 0, 값이 다르면 -1 @n FUTEX_WAKE: 깨운 스레드 수 @n 잘못된 op는 -1
+ */
+int
+futex (int *uaddr, int op, int val) {
+	const int *kaddr = futex_kaddr (uaddr);
+
+	switch (op) {
+	case FUTEX_WAIT:
+		return futex_wait (kaddr, val);
+	case FUTEX_WAKE:
+		return val > 0 ? futex_wake (kaddr, val) : 0;
+	default:
+		return -1;
+	}
+}
+
+// UADDR 뒤에 있는 프레임에서의 커널 주소를 구한다. 잘못된 주소면 프로세스를 종료한다.
+static const int *
+futex_kaddr (int *uaddr) {
+	struct thread *curr = thread_current ();
+	void *kaddr;
+
+	if (uaddr == NULL || !is_user_vaddr (uaddr) || (uintptr_t) uaddr % sizeof (int) != 0)
+		exit (-1);
+	// vDSO 페이지는 모든 프로세스가 공유하는 읽기 전용 커널 데이터라 futex 워드가 될 수 없다.
+	if (vdso_overlaps (uaddr, sizeof *uaddr))
+		exit (-1);
+	kaddr = pml4_get_page (curr->pml4, uaddr);
+#ifdef VM
+	if (kaddr == NULL && vm_claim_page (pg_round_down (uaddr))) // 아직 로드되지 않은 페이지
+		kaddr = pml4_get_page (curr->pml4, uaddr);
+#endif
+	if (kaddr == NULL)
+		exit (-1);
+	return kaddr;
+}
+
+/*------------------------- [P2] Clock --------------------------*/
+/**
+ * @brief 부팅 이후 지난 시간을 나노초 단위로 반환한다.
+ * @details TSC 기반이라 틱(TIMER_FREQ)보다 훨씬 세밀하므로 @n
+ * 시스템 콜이나 페이지 폴트 지연 시간을 마이크로초 단위로 잴 수 있다.
+ * @return uint64_t 부팅 이후 나노초
+ */
+uint64_t
+clock_ns (void) {
+	return timer_ns ();
+}
+
+/**
+ * @brief 프로세스의 스케줄링 통계(CPU 사용 시간, 스위치 수, 레디 큐 대기 시간)를 복사한다.
+ * @param pid 자기 자신(0 또는 자신의 pid)이거나 아직 wait 하지 않은 자식 프로세스
+ * @param stats 통계를 받을 유저 버퍼
+ * @return int 성공하면 0, 해당 프로세스가 없으면 -1
+ */
+int
+sched_stats (pid_t pid, struct sched_stats *stats) {
+	struct thread *curr = thread_current ();
+	struct thread *t;
+	struct sched_stats copy;
+
+#ifdef VM
+	check_buffer (stats, sizeof *stats, false); // read()처럼 쓰기 가능한 페이지여야 한다.
+#else
+	check_address (stats);
+	check_address ((uint8_t *) stats + sizeof *stats - 1);
+#endif
+	t = pid == 0 || pid == curr->tid ? curr : get_child_process (pid);
+	if (t == NULL)
+		return -1;
+	thread_get_stats (t, &copy);
+	memcpy (stats, &copy, sizeof copy);
+	return 0;
+}
+
 /*------------------------- [P2] System Call - fd function --------------------------*/
 /**
  * @brief 주소 값이 유효한 주소 영역인지 확인
@@ -497,26 +631,13 @@ check_buffer(void* buffer, unsigned size, bool writable) {
 
 /**
  * @brief fd table에 해당 파일 저장, fd 생성
- * @details Hanyang Univ. process_add_file 각색
+ * @details Hanyang Univ. process_add_file 각색 @n 가장 작은 빈 fd를 사용한다. (userprog/fdt.c)
  * @param f 새로 fd를 생성하려는 파일 객체(*file)
  * @return int 성공 시 fd, 실패 시 -1(STDERR_FILENO)
  */
 static int 
 fdt_add_fd(struct file *f) {
-	struct thread *curr = thread_current();
-	struct file **fdt = curr->fdt;
-
-	// fd가 제한 범위를 넘지 않고 fdt의 인덱스 위치와 일치 시
-	while (curr->next_fd < FDCOUNT_LIMIT && fdt[curr->next_fd]) {
-		curr->next_fd++;
-	}
-
-	// fdt가 가득 찼을 때 return -1
-	if (curr->next_fd >= FDCOUNT_LIMIT)
-		return -1;
-
-	fdt[curr->next_fd] = f; // fdt에 해당 fd 새로 넣어줌
-	return curr->next_fd;
+	return fdt_add(&thread_current()->fdt, f);
 }
 
 /**
@@ -527,11 +648,7 @@ fdt_add_fd(struct file *f) {
  */
 static struct file *
 fdt_get_file(int fd) {
-	struct thread *curr = thread_current();
-	if (fd < STDIN_FILENO || fd >= FDCOUNT_LIMIT) { // 실패
-		return NULL;
-	}
-	return curr->fdt[fd]; // 성공
+	return fdt_get(&thread_current()->fdt, fd); // stdin, stdout은 fdt에 들어있지 않다.
 }
 
 /**
@@ -541,10 +658,5 @@ fdt_get_file(int fd) {
  */
 static void 
 fdt_remove_fd(int fd) {
-	struct thread *curr = thread_current();
-
-	if (fd < STDIN_FILENO || fd >= FDCOUNT_LIMIT) // 실패
-		return;
-	
-	curr->fdt[fd] = NULL; // 성공
+	fdt_remove(&thread_current()->fdt, fd);
 }
@@ -4,3 +4,6 @@ userprog_SRC += userprog/syscall-entry.S # System call entry.
 userprog_SRC += userprog/syscall.c	# System call handler.
 userprog_SRC += userprog/gdt.c		# GDT initialization.
 userprog_SRC += userprog/tss.c		# TSS management.
+userprog_SRC += userprog/fdt.c		# File descriptor table.
+userprog_SRC += userprog/futex.c	# Futex wait queues.
+userprog_SRC += userprog/vdso.c		# Kernel data pages for user space.
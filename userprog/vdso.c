@@ -0,0 +1,77 @@
+#include "userprog/vdso.h"
+#include <debug.h>
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+
+/* Clock page, shared by all processes.  Null until vdso_init(). */
+struct vdso_time *vdso_time;
+
+/* Allocates the clock page. */
+void
+vdso_init (void) {
+	vdso_time = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+	vdso_time->timer_freq = TIMER_FREQ;
+}
+
+/* Maps the clock page and a fresh process page for T into T's
+   page table, both read-only.  Returns true if successful, false
+   if memory ran out. */
+bool
+vdso_map (struct thread *t) {
+	void *time_upage = (void *) VDSO_ADDR;
+	void *proc_upage = (void *) VDSO_PROC_ADDR;
+
+	ASSERT (t->pml4 != NULL);
+	ASSERT (t->vdso == NULL);
+
+	t->vdso = palloc_get_page (PAL_ZERO);
+	if (t->vdso == NULL)
+		return false;
+	t->vdso->pid = t->tid;
+	t->vdso->cpu = t->cpu != NULL ? t->cpu->id : 0;
+
+	if (!pml4_set_page (t->pml4, time_upage, vdso_time, false)
+			|| !pml4_set_page (t->pml4, proc_upage, t->vdso, false)) {
+		vdso_unmap (t);
+		return false;
+	}
+	return true;
+}
+
+/* Removes T's mappings and frees its process page.  Must be
+   called before T's page table is destroyed, which would free
+   the shared clock page along with it otherwise. */
+void
+vdso_unmap (struct thread *t) {
+	if (t->pml4 != NULL) {
+		pml4_clear_page (t->pml4, (void *) VDSO_ADDR);
+		pml4_clear_page (t->pml4, (void *) VDSO_PROC_ADDR);
+	}
+	if (t->vdso != NULL) {
+		palloc_free_page (t->vdso);
+		t->vdso = NULL;
+	}
+}
+
+/* Records the CPU that NEXT is about to run on.  Called on every
+   context switch. */
+void
+vdso_activate (struct thread *next) {
+	if (next->vdso != NULL)
+		next->vdso->cpu = this_cpu ()->id;
+}
+
+/* Returns true if the SIZE bytes starting at user address UADDR
+   overlap either page.  The pages are only in the page table, not
+   in the supplemental page table, so mmap() has to ask here before
+   it places a mapping on top of them. */
+bool
+vdso_overlaps (const void *uaddr, size_t size) {
+	uint64_t start = (uint64_t) uaddr;
+
+	return start < VDSO_END
+		&& (start >= VDSO_ADDR || VDSO_ADDR - start < size);
+}
@@ -3,6 +3,7 @@
 #include "vm/vm.h"
 #include "userprog/process.h" // lazy_load_segment
 #include "threads/mmu.h" // function "pml4*"
+#include "threads/slab.h"
 
 static bool file_backed_swap_in (struct page *page, void *kva);
 static bool file_backed_swap_out (struct page *page);
@@ -65,7 +66,7 @@ do_mmap (void *addr, size_t length, int writable,
 		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
 		size_t page_zero_bytes = page_read_bytes == PGSIZE ? 0 : PGSIZE - page_read_bytes;
 
-        struct segment_aux *segment_aux = (struct segment_aux*)malloc(sizeof(struct segment_aux));
+        struct segment_aux *segment_aux = kmem_cache_alloc(segment_aux_cache);
         segment_aux->file = re_file;
         segment_aux->offset = offset;
         segment_aux->page_read_bytes = page_read_bytes;
@@ -1,6 +1,7 @@
 /* vm.c: Generic interface for virtual memory objects. */
 
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
 
@@ -12,6 +13,11 @@
 static struct list frame_table;
 /*-------------------------[P3]frame table---------------------------------*/
 
+/*------------------------- [P3] Slab Allocator --------------------------*/
+static struct kmem_cache *page_cache; // struct page 전용 슬랩 캐시
+static struct kmem_cache *frame_cache; // struct frame 전용 슬랩 캐시
+struct kmem_cache *segment_aux_cache; // struct segment_aux 전용 슬랩 캐시 (userprog/process.h)
+
 static unsigned hash_func (const struct hash_elem *e, void *aux UNUSED); // Implement hash_hash_func
 static unsigned less_func(const struct hash_elem *a, const struct hash_elem *b, void *aux); // Implement hash_less_func
 static bool insert_page(struct hash *h, struct page *p);
@@ -32,6 +38,10 @@ vm_init (void) {
 	/* DO NOT MODIFY UPPER LINES. */
 	/* TODO: Your code goes here. */
 	list_init(&frame_table); // frame_table에 대한 초기화
+	page_cache = kmem_cache_create ("page", sizeof (struct page), NULL);
+	frame_cache = kmem_cache_create ("frame", sizeof (struct frame), NULL);
+	segment_aux_cache = kmem_cache_create ("segment_aux",
+			sizeof (struct segment_aux), NULL);
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -52,7 +62,8 @@ page_get_type (struct page *page) {
 
 /* Helpers */
 static struct frame *vm_get_victim (void);
-static bool vm_do_claim_page (struct page *page);
+static bool vm_do_claim_page (struct page *page, uint64_t *pml4);
+static bool share_file_page (struct thread *parent, struct page *parent_page);
 static struct frame *vm_evict_frame (void);
 
 /* Create the pending page object with initializer. If you want to create a
@@ -87,7 +98,7 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable, v
 		 * 페이지를 만들고 vm유형에 따라 이니셜을 가져온 다음 uninit_new를 호출하여 uninit 페이지 구조를 만듦
 		 * uninit_new를 호출한 후 필드를 수정해야 함*/
 		/*-------------------------[P3]Anonoymous page---------------------------------*/
-		struct page* pg = calloc(1, sizeof(struct page)); // ! malloc -> calloc
+		struct page* pg = kmem_cache_zalloc(page_cache); // ! malloc -> calloc -> 슬랩 캐시
 
 		// 페이지 타입에 따라 initializer가 될 초기화 함수를 매칭해준다.
 		typedef bool (*initializer_by_type)(struct page *, enum vm_type, void *);
@@ -129,7 +140,7 @@ spt_find_page (struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
 	// 가상 메모리 주소에 해당하는 페이지 번호 추출 (pg_round_down())
 	// hash_find() 함수를 이용하여 vm_entry 검색 후 반환
 	
-	struct page *page = (struct page*)malloc(sizeof(struct page));	// 임의의 페이지 만들어주기
+	struct page page;	// 임의의 페이지 만들어주기 (검색 키로만 쓰므로 스택에 둔다.)
 	// ↳ page를 새로 만들어주는 이유? : 해당 가상 주소에 대응하는 해시 값 도출을 위함
 	//   page 생성 시, hash_elem도 생성된다.
 	struct hash_elem *e;
@@ -139,10 +150,9 @@ spt_find_page (struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
 	// spt의 hash 테이블 구조체를 인자로 넣어야 하는데 va만 인자로 받아왔기 때문에,
 	// dummy 페이지를 만들고 해당 페이지의 가상주소를 va로 만듦
 	// va가 속해있는 페이지 시작 주소를 갖는 page를 만듦(pg_round_down)
-	page->va = pg_round_down(va);
+	page.va = pg_round_down(va);
 	/* e와 같은 해시값을 갖는 page를 spt에서 찾은 다음 해당 hash_elem을 리턴 */
-	e = hash_find(&spt->spt_hash, &page->hash_elem);
-	free(page);
+	e = hash_find(&spt->spt_hash, &page.hash_elem);
 
 	if (e == NULL)
 		return NULL;
@@ -220,8 +230,8 @@ vm_get_frame (void) { //프레임 할당
 	/*-------------------------[P3]frame table---------------------------------*/
 	// struct frame *frame = NULL;
 
-	struct frame *frame = (struct frame*)malloc(sizeof(struct frame)); 
-	// frame 구조체를 위한 공간 할당한다.(작으므로 malloc으로 _Gitbook Memory Allocation 참조)
+	struct frame *frame = kmem_cache_alloc(frame_cache); 
+	// frame 구조체를 위한 공간 할당한다.(작으므로 슬랩 캐시에서 받는다. _Gitbook Memory Allocation 참조)
 
 	frame->kva = palloc_get_page(PAL_USER); 
 	// 사용 가능한 단일 페이지(물리적 페이지)를 가져온다. 
@@ -324,12 +334,13 @@ vm_claim_page (void *va UNUSED) {
 	if (page == NULL)
 		return false;
 
-	return vm_do_claim_page (page); // 해당 페이지에 프레임을 할당한다.
+	return vm_do_claim_page (page, curr->pml4); // 해당 페이지에 프레임을 할당한다.
 }
 
-/* Claim the PAGE and set up the mmu. */
+/* Claim the PAGE and set up the mmu.  PML4 is the page table of
+   the process that PAGE belongs to. */
 static bool
-vm_do_claim_page (struct page *page) {
+vm_do_claim_page (struct page *page, uint64_t *pml4) {
 	struct frame *frame = vm_get_frame (); // 프레임 하나를 얻는다.
 
 	/* Set links */
@@ -337,9 +348,8 @@ vm_do_claim_page (struct page *page) {
 	page->frame = frame; // 페이지의 물리적 주소로 얻은 프레임을 연결해준다.
 
 	/* TODO: Insert page table entry to map page's VA to frame's PA. */
-    struct thread *curr = thread_current();
 	bool writable = page -> writable; // 해당 페이지의 R/W 여부
-	pml4_set_page(curr->pml4, page->va, frame->kva, writable); // 현재 페이지 테이블에 가상 주소에 따른 frame 매핑
+	pml4_set_page(pml4, page->va, frame->kva, writable); // 페이지 테이블에 가상 주소에 따른 frame 매핑
 
 	return swap_in (page, frame->kva);
 }
@@ -361,6 +371,7 @@ bool
 supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 		struct supplemental_page_table *src UNUSED) {
 	struct thread *curr = thread_current(); // (현재 실행중인)자식 프로세스
+	struct thread *parent = (struct thread *) ((uint8_t *) src - offsetof (struct thread, spt)); // SRC를 가진 부모 프로세스
 
 	struct hash_iterator i; // 부모의 해쉬 테이블을 순회하기 위한 iterator
     hash_first (&i, &src->spt_hash);
@@ -368,9 +379,15 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
         struct page *parent_page = hash_entry (hash_cur (&i), struct page, hash_elem); // 복사하려는 부모 페이지
         enum vm_type parent_type = parent_page->operations->type; // 부모 페이지의 타입에 따라 조건문을 분기한다.
 
+		// CASE 0. 파일 매핑 페이지인 경우 -> 복사하지 않고 부모와 같은 프레임을 공유한다.
+		// ↳ 한쪽이 쓴 내용을 다른 쪽도 본다. (MAP_SHARED)
+        if (page_get_type (parent_page) == VM_FILE) {
+            if (!share_file_page (parent, parent_page))
+                return false;
+        }
 		// CASE 1. UNINIT 페이지인 경우 -> ANON 또는 FILE로 페이지 타입 결정
 		// ↳ 페이지만
-        if(parent_type == VM_UNINIT){
+        else if(parent_type == VM_UNINIT){
             if(!vm_alloc_page_with_initializer(parent_page->uninit.type, parent_page->va, \
 				parent_page->writable, parent_page->uninit.init, parent_page->uninit.aux))
                 return false;
@@ -398,6 +415,31 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
     return true;
 }	
 
+/* Maps PARENT_PAGE, a page of one of PARENT's file mappings, into
+   the running process at the same address and onto the same
+   frame, so that each process sees what the other writes there.
+   If the page is not in memory yet, it is loaded into PARENT
+   first, so that both processes share it from the start.
+   Returns true if successful, false if memory ran out. */
+static bool
+share_file_page (struct thread *parent, struct page *parent_page) {
+	struct thread *curr = thread_current ();
+	struct page *page;
+
+	if (parent_page->frame == NULL && !vm_do_claim_page (parent_page, parent->pml4))
+		return false;
+
+	// 매핑의 파일 정보(aux)는 부모 페이지와 같이 쓴다. munmap이 이를 보고 파일에 다시 쓴다.
+	if (!vm_alloc_page_with_initializer (VM_FILE, parent_page->va, parent_page->writable,
+				NULL, parent_page->uninit.aux))
+		return false;
+	page = spt_find_page (&curr->spt, parent_page->va);
+	page->frame = parent_page->frame;
+	if (!pml4_set_page (curr->pml4, page->va, page->frame->kva, page->writable))
+		return false;
+	return swap_in (page, page->frame->kva); // init이 없으므로 내용은 그대로 두고 file 페이지가 된다.
+}
+
 /* Free the resource hold by the supplemental page table */
 void
 supplemental_page_table_kill (struct supplemental_page_table *spt UNUSED) {